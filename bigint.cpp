@@ -2,16 +2,704 @@ static char RCSId[] =
     "$Id: bigint.cpp,v 1.16 2015/01/27 20:40:23 David Exp David $";
 #include <iostream>
 #include <vector>
-#include <stack>
+#include <memory>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <unordered_set>
+#include <random>
+#include <chrono>
+#include <list>
+#if defined(__unix__) || defined(__APPLE__)
+#define BIGINT_HAVE_MMAP	// MappedBigInteger is available
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifndef BIGINT_NO_MAIN	// define to use BigInteger without the test program
 #include "ydebug.hpp"	// David's debugging macros, used in main() test program
+#endif
 typedef unsigned long long CHUNK;
 typedef unsigned long long ULONG;
+
+#if __cplusplus >= 201402L
+#define BIGINT_CONSTEXPR14 constexpr	// C++14 allows loops in constexpr
+#else
+#define BIGINT_CONSTEXPR14 inline
+#endif
+
+/*****************************************************************
+ * multiply two CHUNKs: the low half of the double-width product *
+ * is returned and the high half is stored in 'high'             *
+ *****************************************************************/
+BIGINT_CONSTEXPR14 CHUNK mulChunks(CHUNK a, CHUNK b, CHUNK &high)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128) a * b;
+
+    high = (CHUNK) (product >> 64);
+    return (CHUNK) product;
+#else	// portable version, built from 32 x 32 bit products
+    const CHUNK halfMask = 0xffffffffULL;
+    CHUNK lowLow = (a & halfMask) * (b & halfMask);
+    CHUNK lowHigh = (a & halfMask) * (b >> 32);
+    CHUNK highLow = (a >> 32) * (b & halfMask);
+    CHUNK highHigh = (a >> 32) * (b >> 32);
+    CHUNK middle = (lowLow >> 32) + (lowHigh & halfMask) + (highLow & halfMask);
+
+    high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    return (middle << 32) | (lowLow & halfMask);
+#endif
+}
+/****************************************************
+ * read and write a CHUNK as 8 little-endian bytes, *
+ * independent of the byte order of the host        *
+ ****************************************************/
+inline CHUNK loadLittleEndian(const unsigned char *bytes)
+{
+    CHUNK value = 0;
+    int i;
+
+    for (i = sizeof(CHUNK) - 1; i >= 0; --i)
+	value = (value << 8) | bytes[i];
+    return value;
+}
+
+inline void storeLittleEndian(unsigned char *bytes, CHUNK value)
+{
+    unsigned i;
+
+    for (i = 0; i < sizeof(CHUNK); ++i) {
+	bytes[i] = (unsigned char) value;
+	value >>= 8;
+    }
+}
+
+/*****************************************************************
+ * divide the double-width value high:low by divisor, which must *
+ * be greater than high; the quotient is returned and the        *
+ * remainder is stored in 'remainder'                            *
+ *****************************************************************/
+BIGINT_CONSTEXPR14 CHUNK divChunks(CHUNK high, CHUNK low, CHUNK divisor,
+				     CHUNK &remainder)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 dividend = ((unsigned __int128) high << 64) | low;
+
+    remainder = (CHUNK) (dividend % divisor);
+    return (CHUNK) (dividend / divisor);
+#else	// portable version, one quotient bit at a time
+    CHUNK quotient = 0;
+    int i = 0;
+
+    for (; i < 64; ++i) {
+	CHUNK topBit = high >> 63;
+
+	high = (high << 1) | (low >> 63);
+	low <<= 1;
+	quotient <<= 1;
+	if (topBit || high >= divisor) {
+	    high -= divisor;
+	    quotient |= 1;
+	}
+    }
+    remainder = high;
+    return quotient;
+#endif
+}
+
+/******************************************************************
+ * Instrumentation                                                *
+ * Compiled in only when BIGINT_INSTRUMENT is defined; otherwise  *
+ * the BIGINT_SPAN family of macros below expand to nothing and   *
+ * the snapshot is always empty.  Each thread counts into its own *
+ * thread_local block, which snapshots add up on demand.          *
+ ******************************************************************/
+enum InstrumentedOperation {
+    OpAdd,		// plusEquals
+    OpMultiply,		// binaryMultiply
+    OpDivide,		// binaryDivide
+    OpParse,		// strToBigInteger
+    OpPrint,		// writeTo / printOn
+    OpLimbMultiply,	// multiplyMagnitudes
+    OpLimbDivide,	// divideMagnitudes
+    NumInstrumentedOperations
+};
+
+enum AlgorithmTier {
+    TierTrivial,	// zero, one or equal operands
+    TierLinear,		// one pass over the limbs
+    TierBinary,		// one bit at a time
+    TierSchoolbook,	// one limb at a time, quadratic
+    TierDivideAndConquer,
+    NumAlgorithmTiers
+};
+
+struct OperationStats {
+    ULONG calls;
+    ULONG limbs;		// size of the operands, in limbs
+    ULONG bytesHeld;		// see BIGINT_HELD
+    ULONG nanoseconds;
+    ULONG tierCalls[NumAlgorithmTiers];
+};
+
+struct InstrumentSnapshot {
+    OperationStats operations[NumInstrumentedOperations];
+};
+
+// layout of the raw counters behind each OperationStats
+enum InstrumentField {
+    FieldCalls,
+    FieldLimbs,
+    FieldBytesHeld,
+    FieldNanoseconds,
+    FieldTiers,		// one counter per AlgorithmTier from here on
+    NumInstrumentFields = FieldTiers + NumAlgorithmTiers
+};
+
+/******************************************************************
+ * optional tracing hook, called at the start (begin == true) and *
+ * end of every instrumented span                                 *
+ ******************************************************************/
+typedef void (*InstrumentTrace)(InstrumentedOperation operation, bool begin,
+				ULONG limbs, void *context);
+
+inline const char *instrumentOperationName(InstrumentedOperation operation)
+{
+    static const char *names[NumInstrumentedOperations] = {
+	"add", "multiply", "divide", "parse", "print",
+	"limbMultiply", "limbDivide"
+    };
+    return names[operation];
+}
+
+inline const char *instrumentTierName(AlgorithmTier tier)
+{
+    static const char *names[NumAlgorithmTiers] = {
+	"trivial", "linear", "binary", "schoolbook", "divideAndConquer"
+    };
+    return names[tier];
+}
+
+#if defined(BIGINT_INSTRUMENT)
+/*******************************************************************
+ * per-thread counters; only the owning thread writes them, so the *
+ * relaxed load-then-store increments need no locked instructions  *
+ *******************************************************************/
+struct ThreadCounters {
+    std::atomic<ULONG> counts[NumInstrumentedOperations][NumInstrumentFields];
+
+    ThreadCounters();
+    ~ThreadCounters();
+
+    void add(int operation, int field, ULONG amount)
+    {
+	std::atomic<ULONG> &count = counts[operation][field];
+	count.store(count.load(std::memory_order_relaxed) + amount,
+		    std::memory_order_relaxed);
+    }
+};
+
+/*****************************************************************
+ * every live thread's counters, plus the totals of threads that *
+ * have exited; a reset records a baseline instead of touching   *
+ * counters that belong to other threads                         *
+ *****************************************************************/
+struct InstrumentRegistry {
+    std::mutex lock;
+    std::list<ThreadCounters *> threads;
+    ULONG retired[NumInstrumentedOperations][NumInstrumentFields];
+    ULONG baseline[NumInstrumentedOperations][NumInstrumentFields];
+    std::atomic<InstrumentTrace> trace;
+    std::atomic<void *> traceContext;
+
+    static InstrumentRegistry &instance()
+    {
+	static InstrumentRegistry registry;
+	return registry;
+    }
+
+    // sum of all counters ever recorded, by operation and field
+    void totals(ULONG (&sum)[NumInstrumentedOperations][NumInstrumentFields])
+    {
+	std::list<ThreadCounters *>::iterator thread;
+	int op, field;
+
+	for (op = 0; op < NumInstrumentedOperations; ++op)
+	    for (field = 0; field < NumInstrumentFields; ++field)
+		sum[op][field] = retired[op][field];
+	for (thread = threads.begin(); thread != threads.end(); ++thread)
+	    for (op = 0; op < NumInstrumentedOperations; ++op)
+		for (field = 0; field < NumInstrumentFields; ++field)
+		    sum[op][field] += (*thread)->counts[op][field].load(
+					  std::memory_order_relaxed);
+    }
+
+    private:
+    InstrumentRegistry() :trace(0), traceContext(0)
+    {
+	memset(retired, 0, sizeof(retired));
+	memset(baseline, 0, sizeof(baseline));
+    }
+};
+
+inline ThreadCounters::ThreadCounters()
+{
+    InstrumentRegistry &registry = InstrumentRegistry::instance();
+    int op, field;
+
+    for (op = 0; op < NumInstrumentedOperations; ++op)
+	for (field = 0; field < NumInstrumentFields; ++field)
+	    counts[op][field].store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.threads.push_back(this);
+}
+
+inline ThreadCounters::~ThreadCounters()
+{
+    InstrumentRegistry &registry = InstrumentRegistry::instance();
+    int op, field;
+
+    std::lock_guard<std::mutex> guard(registry.lock);
+    for (op = 0; op < NumInstrumentedOperations; ++op)
+	for (field = 0; field < NumInstrumentFields; ++field)
+	    registry.retired[op][field] +=
+		counts[op][field].load(std::memory_order_relaxed);
+    registry.threads.remove(this);
+}
+
+inline ThreadCounters &threadCounters()
+{
+    static thread_local ThreadCounters counters;
+    return counters;
+}
+
+/****************************************************************
+ * times one call of an instrumented routine, from construction *
+ * to destruction, and records it in the thread's counters      *
+ ****************************************************************/
+class InstrumentSpan
+{
+    private:
+    InstrumentedOperation operation;
+    ULONG limbs;
+    std::chrono::steady_clock::time_point start;
+
+    public:
+    InstrumentSpan(InstrumentedOperation operationArg, ULONG limbsArg)
+	:operation(operationArg), limbs(limbsArg)
+    {
+	InstrumentRegistry &registry = InstrumentRegistry::instance();
+	InstrumentTrace trace = registry.trace.load(std::memory_order_acquire);
+
+	if (trace)
+	    trace(operation, true, limbs, registry.traceContext.load());
+	start = std::chrono::steady_clock::now();
+    }
+
+    ~InstrumentSpan()
+    {
+	ULONG elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			    std::chrono::steady_clock::now() - start).count();
+	ThreadCounters &counters = threadCounters();
+	InstrumentRegistry &registry = InstrumentRegistry::instance();
+	InstrumentTrace trace = registry.trace.load(std::memory_order_acquire);
+
+	counters.add(operation, FieldCalls, 1);
+	counters.add(operation, FieldLimbs, limbs);
+	counters.add(operation, FieldNanoseconds, elapsed);
+	if (trace)
+	    trace(operation, false, limbs, registry.traceContext.load());
+    }
+
+    void tier(AlgorithmTier chosen)
+    {
+	threadCounters().add(operation, FieldTiers + chosen, 1);
+    }
+
+    void held(ULONG bytes)
+    {
+	threadCounters().add(operation, FieldBytesHeld, bytes);
+    }
+
+    // for routines that only learn their size as they go
+    void setLimbs(ULONG limbsArg)
+    {
+	limbs = limbsArg;
+    }
+};
+
+/****************************************************************
+ * BIGINT_HELD records the storage a routine's result and main  *
+ * scratch vectors hold once it has sized them, not every byte  *
+ * allocated on the way: regrowth and temporaries, Karatsuba's  *
+ * sub-product buffers among them, are not seen                 *
+ ****************************************************************/
+#define BIGINT_SPAN(operation, limbs) \
+    InstrumentSpan instrumentSpan(operation, limbs)
+#define BIGINT_TIER(chosen)	instrumentSpan.tier(chosen)
+#define BIGINT_HELD(bytes)	instrumentSpan.held(bytes)
+#define BIGINT_LIMBS(count)	instrumentSpan.setLimbs(count)
+#else
+#define BIGINT_SPAN(operation, limbs)
+#define BIGINT_TIER(chosen)
+#define BIGINT_HELD(bytes)
+#define BIGINT_LIMBS(count)
+#endif	// BIGINT_INSTRUMENT
+
+/************************************************************
+ * counters gathered from every thread since the last reset *
+ * (all zero when instrumentation is compiled out)          *
+ ************************************************************/
+inline InstrumentSnapshot instrumentSnapshot()
+{
+    InstrumentSnapshot snapshot;
+
+    memset(&snapshot, 0, sizeof(snapshot));
+#if defined(BIGINT_INSTRUMENT)
+    InstrumentRegistry &registry = InstrumentRegistry::instance();
+    ULONG sum[NumInstrumentedOperations][NumInstrumentFields];
+    int op, tier;
+
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.totals(sum);
+    for (op = 0; op < NumInstrumentedOperations; ++op) {
+	const ULONG *count = sum[op];
+	const ULONG *base = registry.baseline[op];
+	OperationStats &stats = snapshot.operations[op];
+
+	stats.calls = count[FieldCalls] - base[FieldCalls];
+	stats.limbs = count[FieldLimbs] - base[FieldLimbs];
+	stats.bytesHeld = count[FieldBytesHeld] - base[FieldBytesHeld];
+	stats.nanoseconds = count[FieldNanoseconds] - base[FieldNanoseconds];
+	for (tier = 0; tier < NumAlgorithmTiers; ++tier)
+	    stats.tierCalls[tier] = count[FieldTiers + tier]
+				      - base[FieldTiers + tier];
+    }
+#endif
+    return snapshot;
+}
+
+inline void instrumentReset()
+{
+#if defined(BIGINT_INSTRUMENT)
+    InstrumentRegistry &registry = InstrumentRegistry::instance();
+
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.totals(registry.baseline);
+#endif
+}
+
+/***************************************************************
+ * install (or, with 0, remove) the tracing hook; the hook may *
+ * be called from any thread doing BigInteger arithmetic       *
+ ***************************************************************/
+inline void setInstrumentTrace(InstrumentTrace trace, void *context = 0)
+{
+#if defined(BIGINT_INSTRUMENT)
+    InstrumentRegistry &registry = InstrumentRegistry::instance();
+
+    registry.trace.store(0, std::memory_order_release);
+    registry.traceContext.store(context);
+    registry.trace.store(trace, std::memory_order_release);
+#else
+    (void) trace;
+    (void) context;
+#endif
+}
+
+/*************************************************************
+ * Random number sources                                     *
+ * BigInteger's random functions draw whole limbs from a     *
+ * RandomSource.  fill() is virtual as well as next(), so a  *
+ * generator can fill a long run of limbs without a call per *
+ * limb.  None of these are suitable for cryptographic use.  *
+ *************************************************************/
+class RandomSource
+{
+    public:
+    virtual ~RandomSource()
+    {
+    }
+
+    // 64 uniformly distributed bits
+    virtual CHUNK next() = 0;
+
+    virtual void fill(CHUNK *limbs, size_t count)
+    {
+	size_t i;
+
+	for (i = 0; i < count; ++i)
+	    limbs[i] = next();
+    }
+};
+
+/**************************************************************
+ * splitmix64: a counter passed through a 64-bit mix; it also *
+ * expands a single seed into the state of Xoshiro256         *
+ **************************************************************/
+class SplitMix64 : public RandomSource
+{
+    private:
+    CHUNK state;
+
+    public:
+    explicit SplitMix64(CHUNK seed) :state(seed)
+    {
+    }
+
+    CHUNK next()
+    {
+	CHUNK z = (state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+    }
+};
+
+/******************************************************************
+ * xoshiro256**, the default source: 256 bits of state and period *
+ * 2^256 - 1, at a few cycles per limb                            *
+ * see: Blackman and Vigna, "Scrambled Linear Pseudorandom Number *
+ * Generators", ACM Transactions on Mathematical Software 47(4),  *
+ * 2021                                                           *
+ ******************************************************************/
+class Xoshiro256 : public RandomSource
+{
+    private:
+    CHUNK state[4];
+
+    static CHUNK rotateLeft(CHUNK value, int bits)
+    {
+	return (value << bits) | (value >> (64 - bits));
+    }
+
+    // not virtual, so that fill()'s loop can inline it
+    CHUNK step()
+    {
+	CHUNK result = rotateLeft(state[1] * 5, 7) * 9;
+	CHUNK t = state[1] << 17;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotateLeft(state[3], 45);
+	return result;
+    }
+
+    public:
+    // the same seed always produces the same sequence
+    explicit Xoshiro256(CHUNK seedValue)
+    {
+	seed(seedValue);
+    }
+
+    // seeded from std::random_device, different on every run
+    Xoshiro256()
+    {
+	std::random_device device;
+
+	seed(((CHUNK) device() << 32) ^ device());
+    }
+
+    void seed(CHUNK seedValue)
+    {
+	SplitMix64 expand(seedValue);
+	int i;
+
+	for (i = 0; i < 4; ++i)
+	    state[i] = expand.next();
+    }
+
+    CHUNK next()
+    {
+	return step();
+    }
+
+    void fill(CHUNK *limbs, size_t count)
+    {
+	size_t i;
+
+	for (i = 0; i < count; ++i)
+	    limbs[i] = step();
+    }
+
+    /****************************************************************
+     * advance by 2^128 values; successive jumps from one seed give *
+     * non-overlapping streams, e.g. one per thread                 *
+     ****************************************************************/
+    void jump()
+    {
+	static const CHUNK polynomial[] = {
+	    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+	    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+	};
+	CHUNK jumped[4] = { 0, 0, 0, 0 };
+	int i, bit, k;
+
+	for (i = 0; i < 4; ++i)
+	    for (bit = 0; bit < 64; ++bit) {
+		if (polynomial[i] & (1ULL << bit))
+		    for (k = 0; k < 4; ++k)
+			jumped[k] ^= state[k];
+		step();
+	    }
+	for (k = 0; k < 4; ++k)
+	    state[k] = jumped[k];
+    }
+};
+
+// this thread's Xoshiro256, seeded from std::random_device
+inline RandomSource &defaultRandomSource()
+{
+    static thread_local Xoshiro256 source;
+
+    return source;
+}
+
+/*******************************************************************
+ * Cancellation and progress for long-running operations           *
+ * A CancellationToken is a shared flag: every copy sees the same  *
+ * state, so the caller keeps one copy and the work polls another. *
+ *******************************************************************/
+class CancellationToken
+{
+    private:
+    std::shared_ptr<std::atomic<bool> > flag;
+
+    public:
+    CancellationToken() :flag(std::make_shared<std::atomic<bool> >(false))
+    {
+    }
+
+    void cancel()
+    {
+	flag->store(true, std::memory_order_relaxed);
+    }
+
+    bool isCancelled() const
+    {
+	return flag->load(std::memory_order_relaxed);
+    }
+};
+
+// called on the worker thread with the fraction of the work done
+typedef std::function<void (double)> ProgressCallback;
+
+/*****************************************************************
+ * the token and progress callback of the operation running on   *
+ * this thread, if any.  The limb kernels and the pow, printing  *
+ * and factorial loops poll it at their natural boundaries, so a *
+ * cancellation takes effect inside a single long multiply or    *
+ * division.  Only the loop named by 'reporter' reports progress *
+ * (a pow's squarings would otherwise each restart from zero);   *
+ * all of them check for cancellation, which throws.             *
+ *****************************************************************/
+class OperationControl
+{
+    public:
+    enum Reporter {
+	MultiplyRows,		// multiplyMagnitudes, squareMagnitude
+	DivideRows,		// divideMagnitudes
+	PowBits,		// slidingWindowPow
+	PrintDigits,		// writeTo
+	FactorialFactors,	// factorial
+	NestedRows		// sub-products of a Karatsuba multiply
+    };
+
+    // the kernels poll once per this many rows
+    static const ULONG PollInterval = 64;
+
+    private:
+    CancellationToken token;
+    ProgressCallback progress;
+    Reporter reporter;
+    OperationControl *previous;
+
+    static OperationControl *&active()
+    {
+	static thread_local OperationControl *current = 0;
+
+	return current;
+    }
+
+    OperationControl(const OperationControl &);
+    OperationControl &operator= (const OperationControl &);
+
+    public:
+    // installed for this thread until destroyed
+    OperationControl(const CancellationToken &tokenArg,
+		     const ProgressCallback &progressArg, Reporter reporterArg)
+	:token(tokenArg), progress(progressArg), reporter(reporterArg),
+	 previous(active())
+    {
+	active() = this;
+    }
+
+    ~OperationControl()
+    {
+	active() = previous;
+    }
+
+    void report(double fraction) const
+    {
+	if (progress)
+	    progress(fraction);
+    }
+
+    /**********************************************************
+     * done of total steps finished in the loop 'from'; cheap *
+     * when no operation is installed on this thread          *
+     **********************************************************/
+    static void poll(Reporter from, ULONG done, ULONG total)
+    {
+	OperationControl *control = active();
+
+	if (!control)
+	    return;
+	if (control->token.isCancelled())
+	    throw("operation cancelled");
+	if (from == control->reporter && total)
+	    control->report(done < total ? (double) done / total : 1.0);
+    }
+};
+
+template <unsigned Bits, bool Signed = false> class FixedInt;
+
 class BigInteger
 {
     // stream input and output
     friend std::ostream& operator<< (std::ostream &strm, BigInteger bigI);
     friend std::istream& operator>> (std::istream &strm, BigInteger &bigI);
 
+    // companion types that work on the magnitude directly
+    friend class BigAccumulator;
+    friend class BigIntegerView;
+    friend class MappedBigInteger;
+    template <unsigned, bool> friend class FixedInt;
+    friend class MontgomeryContext;
+    friend class FieldElement;
+    friend class RnsBasis;
+    friend class FixedBasePow;
+    template <unsigned> friend class CtModulus;
+    friend class SharedBigInteger;
+    friend class BigIntegerAsync;
+    friend class BigDecimalInteger;
+    friend class BatchWorker;
+
     private:
     std::vector<CHUNK> magnitude;	// each element is considered a 'digit'
 
@@ -29,9 +717,26 @@ class BigInteger
     };
 
     static const unsigned BitsPerByte = 8;
+    static const unsigned BitsPerChunk = sizeof(CHUNK) * BitsPerByte;
     static const CHUNK HIGH_BIT = 1LL << (sizeof(CHUNK)*BitsPerByte - 1);
     static const CHUNK LOW_BIT = 1;
 
+    // operand sizes, in limbs, from which Karatsuba beats schoolbook
+    static const ULONG KaratsubaThreshold = 32;
+    static const ULONG KaratsubaSquareThreshold = 48;
+
+
+    static CHUNK rotateLeft(CHUNK value, unsigned count)
+    {
+	return (value << count) | (value >> (BitsPerChunk - count));
+    }
+
+    // one xxHash64 round: fold a limb into a hash lane
+    static CHUNK hashRound(CHUNK lane, CHUNK limb)
+    {
+	lane += limb * 0xc2b2ae3d27d4eb4fULL;
+	return rotateLeft(lane, 31) * 0x9e3779b185ebca87ULL;
+    }
 
     /********************************
      * return true if value is zero *
@@ -178,8 +883,10 @@ class BigInteger
 	BigInteger mask = 1;
 	BigInteger product(0);
 	ULONG i;
-	static const BigInteger bigZero(0);
-	static const BigInteger bigOne(1);
+	const BigInteger &bigZero = smallConstant(0);
+	const BigInteger &bigOne = smallConstant(1);
+	BIGINT_SPAN(OpMultiply,
+		    multiplicand.magnitude.size() + multiplier.magnitude.size());
 
 	if (isZero(multiplier) || isZero(multiplicand))
 	    product = bigZero;
@@ -188,6 +895,7 @@ class BigInteger
 	else if (multiplicand == bigOne)
 	    product = multiplier;
 	else {
+	    BIGINT_TIER(TierBinary);
 	    addend = multiplicand;
 	    product = bigZero;
 
@@ -206,6 +914,7 @@ class BigInteger
 		product.sign = Negative;
 	}
 
+	BIGINT_HELD(product.magnitude.capacity() * sizeof(CHUNK));
 	return product;
     }
 
@@ -219,8 +928,10 @@ class BigInteger
     {
 	ULONG numBits = dividend.magnitude.size() * sizeof(CHUNK) * BitsPerByte;
 	ULONG i;
-	static const BigInteger bigZero(0);
-	static const BigInteger bigOne(1);
+	const BigInteger &bigZero = smallConstant(0);
+	const BigInteger &bigOne = smallConstant(1);
+	BIGINT_SPAN(OpDivide,
+		    dividend.magnitude.size() + divisor.magnitude.size());
 
 	if (isZero(divisor))
 	    throw("divide by zero");
@@ -233,6 +944,7 @@ class BigInteger
 	if (dividend == divisor)
 	    return bigOne;
 
+	BIGINT_TIER(TierBinary);
 	BigInteger quotient(0);
 	BigInteger mask(bigOne << numBits);
 
@@ -254,6 +966,8 @@ class BigInteger
 	    else
 		quotient.sign = Negative;
 	}
+	BIGINT_HELD((quotient.magnitude.capacity()
+			  + remainder.magnitude.capacity()) * sizeof(CHUNK));
 	return quotient;
     }
 
@@ -262,22 +976,10 @@ class BigInteger
      ***************************************************/
     void strToBigInteger(std::string numStr, int radix, int start, Sign signArg)
     {
-	static const BigInteger bigZero(0);
-	static const BigInteger bigOne(1);
-	static const BigInteger bigTwo(2);
-	static const BigInteger bigThree(3);
-	static const BigInteger bigFour(4);
-	static const BigInteger bigFive(5);
-	static const BigInteger bigSix(6);
-	static const BigInteger bigSeven(7);
-	static const BigInteger bigEight(8);
-	static const BigInteger bigNine(9);
-	static const BigInteger bigTen(10);
-	static const BigInteger bigEleven(11);
-	static const BigInteger bigTwelve(12);
-	static const BigInteger bigThirteen(13);
-	static const BigInteger bigFourteen(14);
-	static const BigInteger bigFifteen(15);
+	// the table is contiguous, so it is indexed by digit value
+	const BigInteger *digits = &smallConstant(0);
+	BIGINT_SPAN(OpParse, 0);
+	BIGINT_TIER(TierBinary);
 
 	unsigned index = start;
 	BigInteger digit;
@@ -290,57 +992,57 @@ class BigInteger
 	bool numStrValid = true;
 	for (; index < len; ++index) {
 	    switch (numStr[index]) {
-	    case '0':	digit = bigZero;
+	    case '0':	digit = digits[0];
 			break;
-	    case '1':	digit = bigOne;
+	    case '1':	digit = digits[1];
 			break;
-	    case '2':	digit = bigTwo;
+	    case '2':	digit = digits[2];
 			break;
-	    case '3':	digit = bigThree;
+	    case '3':	digit = digits[3];
 			break;
-	    case '4':	digit = bigFour;
+	    case '4':	digit = digits[4];
 			break;
-	    case '5':	digit = bigFive;
+	    case '5':	digit = digits[5];
 			break;
-	    case '6':	digit = bigSix;
+	    case '6':	digit = digits[6];
 			break;
-	    case '7':	digit = bigSeven;
+	    case '7':	digit = digits[7];
 			break;
-	    case '8':	digit = bigEight;
+	    case '8':	digit = digits[8];
 			if (radix == 8)
 			    numStrValid = false;
 			break;
-	    case '9':	digit = bigNine;
+	    case '9':	digit = digits[9];
 			if (radix == 8)
 			    numStrValid = false;
 			break;
 	    case 'a':
-	    case 'A':	digit = bigTen;
+	    case 'A':	digit = digits[10];
 			if (radix != 16)
 			    numStrValid = false;
 			break;
 	    case 'b':
-	    case 'B':	digit = bigEleven;
+	    case 'B':	digit = digits[11];
 			if (radix != 16)
 			    numStrValid = false;
 			break;
 	    case 'c':
-	    case 'C':	digit = bigTwelve;
+	    case 'C':	digit = digits[12];
 			if (radix != 16)
 			    numStrValid = false;
 			break;
 	    case 'd':
-	    case 'D':	digit = bigThirteen;
+	    case 'D':	digit = digits[13];
 			if (radix != 16)
 			    numStrValid = false;
 			break;
 	    case 'e':
-	    case 'E':	digit = bigFourteen;
+	    case 'E':	digit = digits[14];
 			if (radix != 16)
 			    numStrValid = false;
 			break;
 	    case 'f':
-	    case 'F':	digit = bigFifteen;
+	    case 'F':	digit = digits[15];
 			if (radix != 16)
 			    numStrValid = false;
 			break;
@@ -362,6 +1064,7 @@ class BigInteger
 	    this->sign = Positive;	// keep zero positive
 	else
 	    this->sign = signArg;
+	BIGINT_LIMBS(this->magnitude.size());
     }
 
     /*********************************
@@ -402,44 +1105,7 @@ class BigInteger
      ***********************************/
     void printOn(std::ostream& strm) const
     {
-	BigInteger bigRadix;
-	std::stack<int> digitStack;
-
-	if (this->sign == Negative)
-	    strm << "-";
-
-	if (isZero(*this)) {
-	    strm << "0BI";
-	    return;
-	}
-
-	if (strm.flags() & std::ios::hex)
-	    bigRadix = 16;
-	else if (strm.flags() & std::ios::oct)
-	    bigRadix = 8;
-	else	// assume decimal
-	    bigRadix = 10;
-
-	BigInteger tmp(*this);
-	BigInteger remainder;
-
-	// extract individual digits from number (in reverse order)
-	while (!isZero(tmp)) {
-	    tmp = binaryDivide(tmp, bigRadix, remainder);
-	    digitStack.push(remainder.magnitude[0]);
-	}
-
-	// display individual digits in the proper order
-	while (!digitStack.empty()) {
-	    strm << digitStack.top();
-	    digitStack.pop();
-	}
-
-	strm << "BI";	// denote a big integer
-
-	// for debugging, show number of CHUNKs needed to store value
-	if (this->magnitude.size() > 1)
-	    strm << this->magnitude.size();
+	writeTo(strm, true);
     }
 
     /************************************************************
@@ -594,6 +1260,8 @@ class BigInteger
      **************************************************************/
     BigInteger plusEquals (BigInteger other)
     {
+	BIGINT_SPAN(OpAdd, this->magnitude.size() + other.magnitude.size());
+
 	if (isZero(*this)) {
 	    *this = other;
 	    return *this;
@@ -603,6 +1271,7 @@ class BigInteger
 	    return *this;
 
 	// if we reach here, neither operand is zero
+	BIGINT_TIER(TierLinear);
 	if (this->sign == other.sign) {
 	    this->addMagnitude(other);
 	    return *this;
@@ -634,36 +1303,861 @@ class BigInteger
 	return *this;
     }
 
-    public:
-    /****************
-     * Constructors *
-     ****************/
-    BigInteger() :sign(Positive)
+    /*****************************************************************
+     * Limb-vector routines                                          *
+     * These work on bare magnitudes, least significant limb first,  *
+     * and are the building blocks for routines that need whole-limb *
+     * arithmetic rather than one bit at a time.                     *
+     *****************************************************************/
+
+    // drop leading zero limbs, always leaving at least one
+    static void trimMagnitude(std::vector<CHUNK> &digits)
     {
-	magnitude.push_back(0);
+	while (digits.size() > 1 && digits.back() == 0)
+	    digits.pop_back();
+	if (digits.empty())
+	    digits.push_back(0);
     }
 
-    BigInteger(const int val)
+    // -1, 0 or 1; both arguments must be trimmed
+    static int compareMagnitudes(const std::vector<CHUNK> &a,
+				 const std::vector<CHUNK> &b)
     {
-	if (val >= 0) {
-	    sign = Positive;
-	    magnitude.push_back(val);
-	} else {
-	    sign = Negative;
-	    magnitude.push_back(-val);
-	}
+	ULONG index;
+
+	if (a.size() != b.size())
+	    return a.size() < b.size() ? -1 : 1;
+	for (index = a.size(); index > 0; --index)
+	    if (a[index - 1] != b[index - 1])
+		return a[index - 1] < b[index - 1] ? -1 : 1;
+	return 0;
     }
 
-    BigInteger(const unsigned int val) :sign(Positive)
+    /****************************************************************
+     * fill digits with 'bits' random bits, trimmed; the limbs come *
+     * from one fill() call and the excess top bits are masked off  *
+     ****************************************************************/
+    static void randomMagnitude(ULONG bits, RandomSource &source,
+				std::vector<CHUNK> &digits)
     {
-	magnitude.push_back(val);
+	ULONG count = (bits + BitsPerChunk - 1) / BitsPerChunk;
+
+	if (count == 0) {
+	    digits.assign(1, 0);
+	    return;
+	}
+	digits.resize(count);
+	source.fill(&digits[0], count);
+	if (bits % BitsPerChunk)
+	    digits.back() &= (LOW_BIT << (bits % BitsPerChunk)) - 1;
+	trimMagnitude(digits);
     }
 
-    BigInteger(const long val)
+    /***********************************************************
+     * divide digits in place by a single CHUNK, returning the *
+     * remainder                                               *
+     ***********************************************************/
+    static CHUNK divideMagnitudeByChunk(std::vector<CHUNK> &digits,
+					CHUNK divisor)
     {
-	if (val >= 0) {
-	    sign = Positive;
-	    magnitude.push_back(val);
+	CHUNK remainder = 0;
+	ULONG index;
+
+	for (index = digits.size(); index > 0; --index)
+	    digits[index - 1] = divChunks(remainder, digits[index - 1],
+					  divisor, remainder);
+	trimMagnitude(digits);
+	return remainder;
+    }
+
+    /***************************************************************
+     * schoolbook product, or Karatsuba's once both operands reach *
+     * KaratsubaThreshold limbs; 'product' must not alias a or b.  *
+     * 'rows' names the loop the schoolbook rows poll as, which is *
+     * NestedRows for the sub-products of a larger multiplication  *
+     ***************************************************************/
+    static void multiplyMagnitudes(const std::vector<CHUNK> &a,
+				   const std::vector<CHUNK> &b,
+				   std::vector<CHUNK> &product,
+				   OperationControl::Reporter rows
+				       = OperationControl::MultiplyRows)
+    {
+	ULONG i, j;
+
+	if (a.size() >= KaratsubaThreshold && b.size() >= KaratsubaThreshold) {
+	    karatsubaMultiply(a, b, product, rows);
+	    return;
+	}
+
+	BIGINT_SPAN(OpLimbMultiply, a.size() + b.size());
+	BIGINT_TIER(TierSchoolbook);
+
+	product.assign(a.size() + b.size(), 0);
+	BIGINT_HELD(product.capacity() * sizeof(CHUNK));
+	for (i = 0; i < a.size(); ++i) {
+	    CHUNK aDigit = a[i];
+	    CHUNK carry = 0;
+
+	    if (i % OperationControl::PollInterval == 0)
+		OperationControl::poll(rows, i, a.size());
+	    if (aDigit == 0)
+		continue;
+	    for (j = 0; j < b.size(); ++j) {
+		CHUNK high;
+		CHUNK low = mulChunks(aDigit, b[j], high);
+
+		low += carry;
+		high += low < carry;
+		low += product[i + j];
+		high += low < product[i + j];
+		product[i + j] = low;
+		carry = high;
+	    }
+	    product[i + b.size()] = carry;
+	}
+	trimMagnitude(product);
+    }
+
+    /***************************************************************
+     * schoolbook square: each cross product a[i] * a[j] is formed *
+     * once and doubled, so about half the limb products of        *
+     * multiplyMagnitudes(a, a); 'square' must not alias a.  Long  *
+     * operands go to Karatsuba, as in multiplyMagnitudes          *
+     ***************************************************************/
+    static void squareMagnitude(const std::vector<CHUNK> &a,
+				std::vector<CHUNK> &square,
+				OperationControl::Reporter rows
+				    = OperationControl::MultiplyRows)
+    {
+	ULONG n = a.size();
+	ULONG i, j;
+	CHUNK carry;
+
+	if (n >= KaratsubaSquareThreshold) {
+	    karatsubaMultiply(a, a, square, rows);
+	    return;
+	}
+
+	BIGINT_SPAN(OpLimbMultiply, 2 * n);
+	BIGINT_TIER(TierSchoolbook);
+
+	square.assign(2 * n, 0);
+	BIGINT_HELD(square.capacity() * sizeof(CHUNK));
+	for (i = 0; i + 1 < n; ++i) {
+	    carry = 0;
+	    if (i % OperationControl::PollInterval == 0)
+		OperationControl::poll(rows, i, n);
+	    if (a[i] == 0)
+		continue;
+	    for (j = i + 1; j < n; ++j) {
+		CHUNK high;
+		CHUNK low = mulChunks(a[i], a[j], high);
+
+		low += carry;
+		high += low < carry;
+		low += square[i + j];
+		high += low < square[i + j];
+		square[i + j] = low;
+		carry = high;
+	    }
+	    square[i + n] = carry;
+	}
+
+	// double the cross products, then add the diagonal a[i]^2
+	carry = 0;
+	for (i = 0; i < 2 * n; ++i) {
+	    CHUNK topBit = square[i] >> (BitsPerChunk - 1);
+
+	    square[i] = (square[i] << 1) | carry;
+	    carry = topBit;
+	}
+	carry = 0;
+	for (i = 0; i < n; ++i) {
+	    CHUNK high;
+	    CHUNK low = mulChunks(a[i], a[i], high);
+
+	    low += carry;
+	    high += low < carry;
+	    square[2 * i] += low;
+	    high += square[2 * i] < low;
+	    square[2 * i + 1] += high;
+	    carry = square[2 * i + 1] < high;
+	}
+	trimMagnitude(square);
+    }
+
+    // digits += addend * 2^(64 * offset), growing digits as needed
+    static void addMagnitudeAt(std::vector<CHUNK> &digits,
+			       const std::vector<CHUNK> &addend, ULONG offset)
+    {
+	CHUNK carry = 0;
+	ULONG i;
+
+	if (digits.size() < offset + addend.size())
+	    digits.resize(offset + addend.size(), 0);
+	for (i = 0; i < addend.size(); ++i) {
+	    CHUNK sum = digits[offset + i] + carry;
+
+	    carry = sum < carry;
+	    sum += addend[i];
+	    carry += sum < addend[i];
+	    digits[offset + i] = sum;
+	}
+	for (i += offset; carry && i < digits.size(); ++i)
+	    carry = ++digits[i] == 0;
+	if (carry)
+	    digits.push_back(carry);
+    }
+
+    // digits -= subtrahend; both trimmed, and digits the larger
+    static void subtractMagnitudeFrom(std::vector<CHUNK> &digits,
+				      const std::vector<CHUNK> &subtrahend)
+    {
+	CHUNK borrow = 0;
+	ULONG i;
+
+	for (i = 0; i < subtrahend.size(); ++i) {
+	    CHUNK digit = digits[i];
+	    CHUNK difference = digit - subtrahend[i];
+
+	    digits[i] = difference - borrow;
+	    borrow = (digit < subtrahend[i]) | (difference < borrow);
+	}
+	for (; borrow && i < digits.size(); ++i)
+	    borrow = digits[i]-- == 0;
+	trimMagnitude(digits);
+    }
+
+    /*********************************************************************
+     * Karatsuba: split both operands at 'half' limbs, a = a1 B + a0 and *
+     * b = b1 B + b0, then a b = z2 B^2 + z1 B + z0 with z0 = a0 b0,     *
+     * z2 = a1 b1 and z1 = (a0 + a1)(b0 + b1) - z0 - z2: three products  *
+     * of half the size in place of four.  When one operand is no        *
+     * longer than half the other, the longer one is cut into slices     *
+     * the length of the shorter instead.  Squares (a and b the same     *
+     * vector) stay squares all the way down                             *
+     * see: Knuth, The Art of Computer Programming vol. 2, 4.3.3 (A)     *
+     *********************************************************************/
+    static void karatsubaMultiply(const std::vector<CHUNK> &a,
+				  const std::vector<CHUNK> &b,
+				  std::vector<CHUNK> &product,
+				  OperationControl::Reporter rows)
+    {
+	const OperationControl::Reporter nested = OperationControl::NestedRows;
+	const std::vector<CHUNK> &longer = a.size() >= b.size() ? a : b;
+	const std::vector<CHUNK> &shorter = a.size() >= b.size() ? b : a;
+	ULONG half = (longer.size() + 1) / 2;
+	std::vector<CHUNK> z0, z1, z2;
+	BIGINT_SPAN(OpLimbMultiply, a.size() + b.size());
+	BIGINT_TIER(TierDivideAndConquer);
+
+	if (shorter.size() <= half) {
+	    ULONG offset;
+
+	    product.assign(1, 0);
+	    for (offset = 0; offset < longer.size();
+		 offset += shorter.size()) {
+		ULONG end = offset + shorter.size() < longer.size()
+			    ? offset + shorter.size() : longer.size();
+		std::vector<CHUNK> slice(longer.begin() + offset,
+					 longer.begin() + end);
+
+		OperationControl::poll(rows, offset, longer.size());
+		trimMagnitude(slice);
+		multiplyMagnitudes(slice, shorter, z0, nested);
+		addMagnitudeAt(product, z0, offset);
+	    }
+	    trimMagnitude(product);
+	    return;
+	}
+
+	std::vector<CHUNK> a0(longer.begin(), longer.begin() + half);
+	std::vector<CHUNK> a1(longer.begin() + half, longer.end());
+	trimMagnitude(a0);
+	trimMagnitude(a1);
+	if (&a == &b) {
+	    squareMagnitude(a0, z0, nested);
+	    OperationControl::poll(rows, 1, 3);
+	    squareMagnitude(a1, z2, nested);
+	    OperationControl::poll(rows, 2, 3);
+	    addMagnitudeAt(a0, a1, 0);
+	    squareMagnitude(a0, z1, nested);
+	} else {
+	    std::vector<CHUNK> b0(shorter.begin(), shorter.begin() + half);
+	    std::vector<CHUNK> b1(shorter.begin() + half, shorter.end());
+	    trimMagnitude(b0);
+	    trimMagnitude(b1);
+	    multiplyMagnitudes(a0, b0, z0, nested);
+	    OperationControl::poll(rows, 1, 3);
+	    multiplyMagnitudes(a1, b1, z2, nested);
+	    OperationControl::poll(rows, 2, 3);
+	    addMagnitudeAt(a0, a1, 0);
+	    addMagnitudeAt(b0, b1, 0);
+	    multiplyMagnitudes(a0, b0, z1, nested);
+	}
+	subtractMagnitudeFrom(z1, z0);
+	subtractMagnitudeFrom(z1, z2);
+
+	product.swap(z0);
+	addMagnitudeAt(product, z1, half);
+	addMagnitudeAt(product, z2, 2 * half);
+	trimMagnitude(product);
+	BIGINT_HELD(product.capacity() * sizeof(CHUNK));
+    }
+
+    /****************************************************************
+     * base^exponent for an odd base > 1, by left-to-right sliding  *
+     * windows: only the odd powers up to 2^window are tabulated,   *
+     * and each run of zero bits costs nothing but squarings        *
+     * see: Menezes, van Oorschot and Vanstone, Handbook of Applied *
+     * Cryptography, algorithm 14.85                                *
+     ****************************************************************/
+    static void slidingWindowPow(const std::vector<CHUNK> &base,
+				 ULONG exponent, std::vector<CHUNK> &result)
+    {
+	std::vector<CHUNK> scratch;
+	int bits = 0;
+	unsigned window, k;
+
+	result.assign(1, 1);
+	if (exponent == 0)
+	    return;
+	while (bits < (int) BitsPerChunk && (exponent >> bits))
+	    ++bits;
+	window = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4
+		 : bits > 23 ? 3 : bits > 6 ? 2 : 1;
+
+	// oddPowers[k] = base^(2k + 1)
+	std::vector<std::vector<CHUNK> > oddPowers(1U << (window - 1));
+	oddPowers[0] = base;
+	if (window > 1) {
+	    std::vector<CHUNK> baseSquared;
+
+	    squareMagnitude(base, baseSquared);
+	    for (k = 1; k < oddPowers.size(); ++k)
+		multiplyMagnitudes(oddPowers[k - 1], baseSquared, oddPowers[k]);
+	}
+
+	bool started = false;
+	int i = bits - 1;
+	while (i >= 0) {
+	    OperationControl::poll(OperationControl::PowBits, bits - 1 - i,
+				   bits);
+	    if (!((exponent >> i) & 1)) {
+		squareMagnitude(result, scratch);
+		result.swap(scratch);
+		--i;
+		continue;
+	    }
+
+	    // the longest window ending in a 1 bit
+	    int low = i - (int) window + 1 > 0 ? i - (int) window + 1 : 0;
+	    while (!((exponent >> low) & 1))
+		++low;
+	    ULONG value = (exponent >> low) & ((2ULL << (i - low)) - 1);
+
+	    if (started) {
+		for (k = 0; k < (unsigned) (i - low + 1); ++k) {
+		    squareMagnitude(result, scratch);
+		    result.swap(scratch);
+		}
+		multiplyMagnitudes(result, oddPowers[value >> 1], scratch);
+		result.swap(scratch);
+	    } else
+		result = oddPowers[value >> 1];
+	    started = true;
+	    i = low - 1;
+	}
+    }
+
+    /*****************************************************************
+     * long division one limb at a time                              *
+     * see: Knuth, The Art of Computer Programming vol. 2, 4.3.1 (D) *
+     * divisor must be trimmed and non-zero; quotient and remainder  *
+     * must not alias the inputs                                     *
+     *****************************************************************/
+    static void divideMagnitudes(const std::vector<CHUNK> &dividend,
+				 const std::vector<CHUNK> &divisor,
+				 std::vector<CHUNK> &quotient,
+				 std::vector<CHUNK> &remainder)
+    {
+	ULONG n = divisor.size();
+	ULONG m = dividend.size();
+	ULONG i, index;
+	BIGINT_SPAN(OpLimbDivide, m + n);
+
+	while (m > 1 && dividend[m - 1] == 0)
+	    --m;
+
+	if (m < n || (m == n && dividend[m - 1] < divisor[n - 1])) {
+	    BIGINT_TIER(TierTrivial);
+	    quotient.assign(1, 0);
+	    remainder.assign(dividend.begin(), dividend.begin() + m);
+	    return;
+	}
+
+	if (n == 1) {
+	    BIGINT_TIER(TierLinear);
+	    quotient.assign(dividend.begin(), dividend.begin() + m);
+	    remainder.assign(1, divideMagnitudeByChunk(quotient, divisor[0]));
+	    return;
+	}
+
+	// normalize so that the divisor's top bit is set
+	unsigned shift = 0;
+	while (!((divisor[n - 1] << shift) & HIGH_BIT))
+	    ++shift;
+
+	BIGINT_TIER(TierSchoolbook);
+	std::vector<CHUNK> v(n), u(m + 1);
+	BIGINT_HELD((n + m + 1) * sizeof(CHUNK));
+	for (i = n; i > 0; --i)
+	    v[i - 1] = (divisor[i - 1] << shift)
+		| (shift && i > 1 ? divisor[i - 2] >> (BitsPerChunk - shift) : 0);
+	u[m] = shift ? dividend[m - 1] >> (BitsPerChunk - shift) : 0;
+	for (i = m; i > 0; --i)
+	    u[i - 1] = (dividend[i - 1] << shift)
+		| (shift && i > 1 ? dividend[i - 2] >> (BitsPerChunk - shift) : 0);
+
+	quotient.assign(m - n + 1, 0);
+	for (index = m - n + 1; index > 0; --index) {
+	    ULONG j = index - 1;
+	    CHUNK qHat, rHat;
+	    bool rHatOverflow = false;
+
+	    if (index % OperationControl::PollInterval == 0)
+		OperationControl::poll(OperationControl::DivideRows,
+				       m - n + 1 - index, m - n + 1);
+
+	    // estimate from the top two limbs, then refine with the third
+	    if (u[j + n] >= v[n - 1]) {
+		qHat = ~(CHUNK) 0;
+		rHat = u[j + n - 1] + v[n - 1];
+		rHatOverflow = rHat < v[n - 1];
+	    } else
+		qHat = divChunks(u[j + n], u[j + n - 1], v[n - 1], rHat);
+
+	    while (!rHatOverflow) {
+		CHUNK high;
+		CHUNK low = mulChunks(qHat, v[n - 2], high);
+
+		if (high < rHat || (high == rHat && low <= u[j + n - 2]))
+		    break;
+		--qHat;
+		rHat += v[n - 1];
+		rHatOverflow = rHat < v[n - 1];
+	    }
+
+	    // u[j..j+n] -= qHat * v
+	    CHUNK carry = 0;
+	    CHUNK borrow = 0;
+	    for (i = 0; i < n; ++i) {
+		CHUNK high;
+		CHUNK low = mulChunks(qHat, v[i], high);
+
+		low += carry;
+		high += low < carry;
+		carry = high;
+
+		CHUNK digit = u[i + j] - low;
+		CHUNK outBorrow = u[i + j] < low;
+		outBorrow += digit < borrow;
+		u[i + j] = digit - borrow;
+		borrow = outBorrow;
+	    }
+	    CHUNK top = u[j + n] - carry;
+	    CHUNK outBorrow = u[j + n] < carry;
+	    outBorrow += top < borrow;
+	    u[j + n] = top - borrow;
+
+	    if (outBorrow) {	// qHat was one too large; add v back
+		--qHat;
+		carry = 0;
+		for (i = 0; i < n; ++i) {
+		    CHUNK digit = u[i + j] + v[i];
+		    CHUNK outCarry = digit < v[i];
+		    digit += carry;
+		    outCarry |= digit < carry;
+		    u[i + j] = digit;
+		    carry = outCarry;
+		}
+		u[j + n] += carry;
+	    }
+	    quotient[j] = qHat;
+	}
+
+	// un-normalize the remainder
+	remainder.resize(n);
+	for (i = 0; i < n; ++i)
+	    remainder[i] = (shift ? u[i] >> shift : u[i])
+		| (shift ? u[i + 1] << (BitsPerChunk - shift) : 0);
+	trimMagnitude(quotient);
+	trimMagnitude(remainder);
+    }
+
+    /**************************************************************
+     * inverse of an odd CHUNK modulo 2^64 by Newton's iteration, *
+     * which doubles the number of correct low bits on every pass *
+     **************************************************************/
+    static CHUNK inverseChunk(CHUNK odd)
+    {
+	CHUNK inverse = odd;	// correct to 3 bits, since odd * odd = 1 mod 8
+	int i;
+
+	for (i = 0; i < 5; ++i)
+	    inverse *= 2 - odd * inverse;
+	return inverse;
+    }
+
+    // number of zero bits below the lowest set bit; digits is non-zero
+    static ULONG trailingZeroBits(const std::vector<CHUNK> &digits)
+    {
+	ULONG index = 0;
+	ULONG bits = 0;
+	CHUNK digit;
+
+	while (digits[index] == 0)
+	    ++index;
+	for (digit = digits[index]; !(digit & 1); digit >>= 1)
+	    ++bits;
+	return index * BitsPerChunk + bits;
+    }
+
+    static void shiftMagnitudeRight(std::vector<CHUNK> &digits, ULONG bits)
+    {
+	ULONG limbShift = bits / BitsPerChunk;
+	unsigned bitShift = bits % BitsPerChunk;
+	ULONG i;
+
+	if (limbShift >= digits.size()) {
+	    digits.assign(1, 0);
+	    return;
+	}
+	digits.erase(digits.begin(), digits.begin() + limbShift);
+	if (bitShift)
+	    for (i = 0; i < digits.size(); ++i)
+		digits[i] = (digits[i] >> bitShift)
+		    | (i + 1 < digits.size()
+		       ? digits[i + 1] << (BitsPerChunk - bitShift) : 0);
+	trimMagnitude(digits);
+    }
+
+    static void shiftMagnitudeLeft(std::vector<CHUNK> &digits, ULONG bits)
+    {
+	ULONG limbShift = bits / BitsPerChunk;
+	unsigned bitShift = bits % BitsPerChunk;
+	ULONG i;
+
+	if (digits.size() == 1 && digits[0] == 0)
+	    return;
+	if (bitShift) {
+	    digits.push_back(0);
+	    for (i = digits.size() - 1; i > 0; --i)
+		digits[i] = (digits[i] << bitShift)
+		    | (digits[i - 1] >> (BitsPerChunk - bitShift));
+	    digits[0] <<= bitShift;
+	}
+	digits.insert(digits.begin(), limbShift, 0);
+	trimMagnitude(digits);
+    }
+
+    // digits *= factor, in place
+    static void multiplyMagnitudeByChunk(std::vector<CHUNK> &digits,
+					 CHUNK factor)
+    {
+	CHUNK carry = 0;
+	ULONG i;
+
+	for (i = 0; i < digits.size(); ++i) {
+	    CHUNK high;
+	    CHUNK low = mulChunks(digits[i], factor, high);
+
+	    low += carry;
+	    high += low < carry;
+	    digits[i] = low;
+	    carry = high;
+	}
+	if (carry)
+	    digits.push_back(carry);
+	trimMagnitude(digits);
+    }
+
+    /*****************************************************************
+     * product of the integers low..high by binary splitting, so the *
+     * large multiplications pair operands of similar size; n, the   *
+     * top of the whole range, only scales the progress reports      *
+     *****************************************************************/
+    static void rangeProduct(ULONG low, ULONG high, ULONG n,
+			     std::vector<CHUNK> &product)
+    {
+	static const ULONG LeafFactors = 16;	// multiplied in one by one
+
+	if (high - low < LeafFactors) {
+	    ULONG k;
+
+	    product.assign(1, 1);
+	    for (k = low; k <= high; ++k)
+		multiplyMagnitudeByChunk(product, k);
+	    OperationControl::poll(OperationControl::FactorialFactors, high, n);
+	    return;
+	}
+
+	ULONG middle = low + (high - low) / 2;
+	std::vector<CHUNK> left, right;
+
+	rangeProduct(low, middle, n, left);
+	rangeProduct(middle + 1, high, n, right);
+	multiplyMagnitudes(left, right, product);
+    }
+
+    /**************************************************************
+     * O(n) divisibility test by an odd single limb, one multiply *
+     * per limb and no division: the result is zero exactly when  *
+     * divisor divides digits (after GMP's mpn_modexact_1_odd)    *
+     **************************************************************/
+    static CHUNK modExactOdd(const std::vector<CHUNK> &digits, CHUNK divisor)
+    {
+	CHUNK inverse = inverseChunk(divisor);
+	CHUNK carry = 0;
+	ULONG i;
+
+	for (i = 0; i < digits.size(); ++i) {
+	    CHUNK digit = digits[i];
+	    CHUNK difference = digit - carry;
+	    CHUNK high;
+
+	    carry = digit < carry;
+	    mulChunks(difference * inverse, divisor, high);
+	    carry += high;
+	}
+	return carry;
+    }
+
+    /****************************************************************
+     * Hensel (right-to-left) division by an odd divisor: each      *
+     * quotient limb is the low limb of what is left times the      *
+     * divisor's inverse mod 2^64, so no division instruction is    *
+     * needed.  With truncate set only the limbs that can still     *
+     * affect the quotient are updated, which is all an exact       *
+     * division needs (Jebelean's method); otherwise the return     *
+     * value tells whether the division was exact.                  *
+     * see: Jebelean, "An algorithm for exact division", Journal of *
+     * Symbolic Computation 15(2), 1993                             *
+     ****************************************************************/
+    static bool henselDivide(std::vector<CHUNK> dividend,
+			     const std::vector<CHUNK> &divisor,
+			     std::vector<CHUNK> &quotient, bool truncate)
+    {
+	ULONG n = divisor.size();
+	ULONG m = dividend.size();
+	CHUNK inverse = inverseChunk(divisor[0]);
+	CHUNK borrow = 0;
+	ULONG i, j;
+
+	if (m < n) {
+	    quotient.assign(1, 0);
+	    return m == 1 && dividend[0] == 0;
+	}
+
+	ULONG quotientSize = m - n + 1;
+	quotient.resize(quotientSize);
+	for (i = 0; i < quotientSize; ++i) {
+	    CHUNK digit = dividend[i] * inverse;
+	    ULONG end = truncate ? quotientSize : m;
+	    CHUNK carry = 0;
+
+	    quotient[i] = digit;
+	    borrow = 0;
+	    for (j = i; j < end; ++j) {
+		if (j - i >= n && !carry && !borrow)
+		    break;	// nothing left to propagate
+
+		CHUNK high = 0;
+		CHUNK low = j - i < n ? mulChunks(digit, divisor[j - i], high) : 0;
+
+		low += carry;
+		high += low < carry;
+		carry = high;
+
+		CHUNK outBorrow = dividend[j] < low;
+		CHUNK difference = dividend[j] - low;
+		outBorrow += difference < borrow;
+		dividend[j] = difference - borrow;
+		borrow = outBorrow;
+	    }
+	    if (!truncate && (carry || borrow))
+		return false;	// quotient * divisor exceeds the dividend
+	}
+	trimMagnitude(quotient);
+	if (truncate)
+	    return true;
+	for (i = quotientSize; i < m; ++i)
+	    if (dividend[i])
+		return false;
+	return true;
+    }
+
+    /***************************************************************
+     * collects digits for writeTo() and hands them to the sink in *
+     * blocks, so output size never drives memory use              *
+     ***************************************************************/
+    class DigitBuffer {
+	public:
+	DigitBuffer(const std::function<void (const char *, size_t)> &sinkArg,
+		    ULONG expectedArg = 0)
+	    :sink(sinkArg), used(0), written(0), expected(expectedArg)
+	{
+	}
+
+	void put(char digit)
+	{
+	    if (used == sizeof(buffer))
+		flush();
+	    buffer[used++] = digit;
+	}
+
+	// hand the buffered digits to the sink, and report progress
+	void flush()
+	{
+	    if (used)
+		sink(buffer, used);
+	    written += used;
+	    used = 0;
+	    OperationControl::poll(OperationControl::PrintDigits, written,
+				   expected);
+	}
+
+	private:
+	const std::function<void (const char *, size_t)> &sink;
+	char buffer[4096];
+	size_t used;
+	ULONG written;
+	ULONG expected;		// roughly how many digits there will be
+    };
+
+    /*******************************************************************
+     * write digits for radix 2, 4, 8, 16 or 32 straight from the bits *
+     *******************************************************************/
+    void writePowerOfTwoDigits(DigitBuffer &out, unsigned bitsPerDigit,
+			       const char *digitChars) const
+    {
+	ULONG numDigits = (bitLength() + bitsPerDigit - 1) / bitsPerDigit;
+	ULONG index;
+
+	for (index = numDigits; index > 0; --index) {
+	    ULONG bit = (index - 1) * bitsPerDigit;
+	    ULONG limb = bit / BitsPerChunk;
+	    unsigned offset = bit % BitsPerChunk;
+	    CHUNK digit = this->magnitude[limb] >> offset;
+
+	    if (offset + bitsPerDigit > BitsPerChunk
+		    && limb + 1 < this->magnitude.size())
+		digit |= this->magnitude[limb + 1] << (BitsPerChunk - offset);
+	    out.put(digitChars[digit & ((1u << bitsPerDigit) - 1)]);
+	}
+    }
+
+    /****************************************************************
+     * write one 'chunk digit' (a value below radix^digitsPerChunk) *
+     * with or without leading zeros                                *
+     ****************************************************************/
+    static void writeChunkDigits(DigitBuffer &out, CHUNK value, int radix,
+				 unsigned digitsPerChunk, bool pad,
+				 const char *digitChars)
+    {
+	char digits[BitsPerChunk];
+	unsigned count = 0;
+
+	while (value || (pad && count < digitsPerChunk) || count == 0) {
+	    digits[count++] = digitChars[value % radix];
+	    value /= radix;
+	}
+	while (count > 0)
+	    out.put(digits[--count]);
+    }
+
+    /*****************************************************************
+     * divide-and-conquer radix conversion                           *
+     * value < powers[level]^2; it is split by powers[level] and the *
+     * high half written before the low half, so digits come out in  *
+     * order as soon as each half is ready.  With 'pad' set, exactly *
+     * 2^(level+1) chunk digits are written, leading zeros included. *
+     * value is consumed to keep the working set down the recursion. *
+     *****************************************************************/
+    static void writeChunks(std::vector<CHUNK> &value, int level, bool pad,
+			    const std::vector<std::vector<CHUNK> > &powers,
+			    int radix, unsigned digitsPerChunk,
+			    DigitBuffer &out, const char *digitChars)
+    {
+	static const ULONG LeafLimbs = 32;	// below this, divide by chunks
+
+	if (level < 0 || value.size() <= LeafLimbs) {
+	    CHUNK chunkBase = powers[0][0];
+	    std::vector<CHUNK> chunkDigits;
+	    ULONG index;
+
+	    while (value.size() > 1 || value[0] != 0)
+		chunkDigits.push_back(divideMagnitudeByChunk(value, chunkBase));
+	    if (pad) {	// leading zero chunks, written without storing them
+		ULONG zeros = ((ULONG) 1 << (level + 1)) - chunkDigits.size();
+		for (; zeros > 0; --zeros)
+		    writeChunkDigits(out, 0, radix, digitsPerChunk, true,
+				     digitChars);
+	    } else if (chunkDigits.empty())
+		chunkDigits.push_back(0);
+
+	    for (index = chunkDigits.size(); index > 0; --index)
+		writeChunkDigits(out, chunkDigits[index - 1], radix,
+				 digitsPerChunk,
+				 pad || index < chunkDigits.size(),
+				 digitChars);
+	    return;
+	}
+
+	std::vector<CHUNK> high, low;
+
+	divideMagnitudes(value, powers[level], high, low);
+	std::vector<CHUNK>().swap(value);	// release it
+
+	if (pad || high.size() > 1 || high[0] != 0) {
+	    writeChunks(high, level - 1, pad, powers, radix, digitsPerChunk,
+			out, digitChars);
+	    pad = true;
+	}
+	writeChunks(low, level - 1, pad, powers, radix, digitsPerChunk,
+		    out, digitChars);
+    }
+
+    public:
+    /****************
+     * Constructors *
+     ****************/
+    BigInteger() :sign(Positive)
+    {
+	magnitude.push_back(0);
+    }
+
+    BigInteger(const int val)
+    {
+	if (val >= 0) {
+	    sign = Positive;
+	    magnitude.push_back(val);
+	} else {
+	    sign = Negative;
+	    magnitude.push_back(-val);
+	}
+    }
+
+    BigInteger(const unsigned int val) :sign(Positive)
+    {
+	magnitude.push_back(val);
+    }
+
+    BigInteger(const long val)
+    {
+	if (val >= 0) {
+	    sign = Positive;
+	    magnitude.push_back(val);
 	} else {
 	    sign = Negative;
 	    magnitude.push_back(-val);
@@ -774,14 +2268,14 @@ class BigInteger
 
     BigInteger operator++ () 	// pre-increment
     {
-	static const BigInteger bigOne(1);
+	const BigInteger &bigOne = smallConstant(1);
 
 	return plusEquals(bigOne);
     }
 
     BigInteger operator++ (int)	// post-increment
     {
-	static const BigInteger bigOne(1);
+	const BigInteger &bigOne = smallConstant(1);
 
 	BigInteger retVal = *this;
 	plusEquals(bigOne);
@@ -790,14 +2284,14 @@ class BigInteger
 
     BigInteger operator-- () 	// pre-decrement
     {
-	static const BigInteger minusOne(-1);
+	const BigInteger &minusOne = smallConstant(-1);
 
 	return plusEquals(minusOne);
     }
 
     BigInteger operator-- (int)	// post-decrement
     {
-	static const BigInteger minusOne(-1);
+	const BigInteger &minusOne = smallConstant(-1);
 
 	BigInteger retVal = *this;
 	plusEquals(minusOne);
@@ -959,64 +2453,5544 @@ class BigInteger
 	*this = remainder;
 	return *this;
     }
-};
 
-// stream input and output
-inline std::ostream& operator<< (std::ostream &strm, BigInteger bigI)
-{
-    bigI.printOn(strm);
-    return strm;
-}
+    /****************************************************************
+     * modular exponentiation: (*this raised to exponent) % modulus *
+     * the result is always in the range [0, modulus).  Defined     *
+     * after BatchWorker, whose kernels and scratch it shares       *
+     ****************************************************************/
+    BigInteger modPow(const BigInteger &exponent, const BigInteger &modulus)
+    const;
 
+    /***************************************************************
+     * interned small constants, MinSmallConstant through          *
+     * MaxSmallConstant: built together on first use and shared by *
+     * reference from then on, so callers pay one initialization   *
+     * guard and no copies.  The table is one array, so a caller   *
+     * needing several may index from one of them                  *
+     ***************************************************************/
+    enum {
+	MinSmallConstant = -1,
+	MaxSmallConstant = 16
+    };
 
-inline std::istream& operator>> (std::istream &strm, BigInteger &bigI)
-{
-    bigI.readFrom(strm);
-    return strm;
-}
+    static const BigInteger &smallConstant(int value)
+    {
+	static const BigInteger table[] = {
+	    BigInteger(-1), BigInteger(0), BigInteger(1), BigInteger(2),
+	    BigInteger(3), BigInteger(4), BigInteger(5), BigInteger(6),
+	    BigInteger(7), BigInteger(8), BigInteger(9), BigInteger(10),
+	    BigInteger(11), BigInteger(12), BigInteger(13), BigInteger(14),
+	    BigInteger(15), BigInteger(16)
+	};
+
+	if (value < MinSmallConstant || value > MaxSmallConstant)
+	    throw("not a small constant");
+	return table[value - MinSmallConstant];
+    }
 
-/* Driver program to for testing */
-int main(int argc, char *argv[])
-{
-    static const BigInteger bigZero(0);
-    static const BigInteger bigTen(10);
-    if (argc > 1) {
-	static const std::string Octal("octal");
-	static const std::string Hex("hex");
-	if (Octal == argv[1]) {
-	    std::cin >> std::oct;
-	    std::cout << std::oct;
-	} else if (Hex == argv[1]) {
-	    std::cin >> std::hex;
-	    std::cout << std::hex;
-	}
+    // the interned copy of value if it is a small constant, else 0
+    static const BigInteger *findSmallConstant(const BigInteger &value)
+    {
+	if (value.magnitude.size() != 1)
+	    return 0;
+
+	CHUNK limb = value.magnitude[0];
+
+	if (value.sign == Negative)
+	    return limb <= (CHUNK) -MinSmallConstant
+		   ? &smallConstant(-(int) limb) : 0;
+	return limb <= (CHUNK) MaxSmallConstant
+	       ? &smallConstant((int) limb) : 0;
     }
-    std::cout << "Input and Output in ";
-    if (std::cin.flags() & std::ios::hex)
-	std::cout << "hex\n";
-    else if (std::cin.flags() & std::ios::oct)
-	std::cout << "octal\n";
-    else
-	std::cout << "decimal\n";
-    try {
-	BigInteger i(static_cast<CHUNK>(-3));
-	BigInteger j(8000000000000000011LL);
-	BigInteger k(i);
-	DB(i==k);
-	DB4(i, j, k, i < j);
-	i += j;
-	DB3(i, j, k);
-	DB4(i>j, j>k, i<j, j<k);
-	DB3(i==k,i==j, j==k);
-	BigInteger a1(-7);
-	BigInteger a2(100);
-	BigInteger a3;
-	DB3(a1, a2, a3);
-	a2 += a1;
-	a3 = a1 + a2;
-	DB3(a1, a2, a3);
-	DB3(a1, a2-a1, a3);
-	DB3(a1, a2+a1, a3);
+
+    /****************************************************************
+     * seedable hash of the sign and limbs (the magnitude is always *
+     * normalized, so equal values hash equally).  Four independent *
+     * lanes take a limb each per step, in the manner of xxHash64,  *
+     * so long values keep several multipliers busy at once         *
+     ****************************************************************/
+    ULONG hash(ULONG seed = 0) const
+    {
+	static const CHUNK Prime1 = 0x9e3779b185ebca87ULL;
+	static const CHUNK Prime2 = 0xc2b2ae3d27d4eb4fULL;
+	static const CHUNK Prime3 = 0x165667b19e3779f9ULL;
+	ULONG size = this->magnitude.size();
+	const CHUNK *limbs = &this->magnitude[0];
+	CHUNK lane[4] = {
+	    seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1
+	};
+	ULONG i = 0;
+	unsigned j;
+
+	for (; i + 4 <= size; i += 4)
+	    for (j = 0; j < 4; ++j)
+		lane[j] = hashRound(lane[j], limbs[i + j]);
+	for (j = 0; i < size; ++i, ++j)
+	    lane[j] = hashRound(lane[j], limbs[i]);
+
+	CHUNK h = rotateLeft(lane[0], 1) + rotateLeft(lane[1], 7)
+		  + rotateLeft(lane[2], 12) + rotateLeft(lane[3], 18);
+	h ^= (size << 1 | (this->sign == Negative)) * Prime3;
+
+	// final avalanche
+	h ^= h >> 33;
+	h *= Prime2;
+	h ^= h >> 29;
+	h *= Prime3;
+	h ^= h >> 32;
+	return h;
+    }
+
+    /***************************************************************
+     * *this raised to exponent.  The power of two in the base is  *
+     * split off and put back with one shift at the end, so a base *
+     * of 2^k costs nothing but that shift; the odd part is raised *
+     * by sliding-window exponentiation                            *
+     ***************************************************************/
+    BigInteger pow(const BigInteger &exponent) const
+    {
+	BigInteger answer;
+
+	if (exponent.sign == Negative)
+	    throw("negative exponent");
+	if (isZero(*this))
+	    return isZero(exponent) ? smallConstant(1) : answer;
+
+	bool negative = this->sign == Negative && (exponent.magnitude[0] & 1);
+	if (this->magnitude.size() == 1 && this->magnitude[0] == 1)
+	    return smallConstant(negative ? -1 : 1);
+	if (exponent.magnitude.size() > 1)
+	    throw("exponent too large");
+
+	ULONG power = exponent.magnitude[0];
+	ULONG twos = trailingZeroBits(this->magnitude);
+	std::vector<CHUNK> odd(this->magnitude);
+
+	if (twos && power > ~(ULONG) 0 / twos)
+	    throw("exponent too large");
+	shiftMagnitudeRight(odd, twos);
+	if (odd.size() == 1 && odd[0] == 1)
+	    answer.magnitude = odd;
+	else
+	    slidingWindowPow(odd, power, answer.magnitude);
+	shiftMagnitudeLeft(answer.magnitude, twos * power);
+	if (negative)
+	    answer.sign = Negative;
+	return answer;
+    }
+
+    // n!, as a balanced product tree of 1..n
+    static BigInteger factorial(ULONG n)
+    {
+	BigInteger answer;
+
+	answer.magnitude.assign(1, 1);
+	if (n > 1)
+	    rangeProduct(2, n, n, answer.magnitude);
+	return answer;
+    }
+
+    /******************************************************************
+     * quotient of a division known to be exact, such as by a gcd or  *
+     * in a binomial coefficient.  Works from the low limbs up with   *
+     * the divisor's inverse mod 2^64 and never forms a remainder, so *
+     * it is much cheaper than '/'; the result is meaningless if      *
+     * divisor does not divide *this                                  *
+     ******************************************************************/
+    BigInteger divExact(const BigInteger &divisor) const
+    {
+	BigInteger quotient;
+	std::vector<CHUNK> dividend(this->magnitude);
+	std::vector<CHUNK> odd(divisor.magnitude);
+
+	if (isZero(divisor))
+	    throw("divide by zero");
+	if (isZero(*this))
+	    return quotient;
+
+	// strip the power of two, which the dividend must share
+	ULONG shift = trailingZeroBits(odd);
+	shiftMagnitudeRight(odd, shift);
+	shiftMagnitudeRight(dividend, shift);
+
+	if (odd.size() == 1 && odd[0] == 1)
+	    quotient.magnitude = dividend;
+	else
+	    henselDivide(dividend, odd, quotient.magnitude, true);
+	if (!isZero(quotient) && this->sign != divisor.sign)
+	    quotient.sign = Negative;
+	return quotient;
+    }
+
+    /****************************************************************
+     * true if divisor divides *this, without a full long division: *
+     * powers of two only look at the low bits, an odd single-limb  *
+     * (after removing the power of two) takes one O(n) congruence  *
+     * pass, and anything else a Hensel division                    *
+     ****************************************************************/
+    bool isDivisibleBy(const BigInteger &divisor) const
+    {
+	std::vector<CHUNK> odd(divisor.magnitude);
+	std::vector<CHUNK> quotient;
+
+	if (isZero(divisor))
+	    throw("divide by zero");
+	if (isZero(*this))
+	    return true;
+
+	ULONG shift = trailingZeroBits(odd);
+	if (trailingZeroBits(this->magnitude) < shift)
+	    return false;
+	shiftMagnitudeRight(odd, shift);
+
+	if (odd.size() == 1 && odd[0] == 1)
+	    return true;
+	if (odd.size() == 1)	// 2^shift divides *this already
+	    return modExactOdd(this->magnitude, odd[0]) == 0;
+
+	std::vector<CHUNK> dividend(this->magnitude);
+	shiftMagnitudeRight(dividend, shift);
+	return henselDivide(dividend, odd, quotient, false);
+    }
+
+    /**************************************************************
+     * number of significant bits in the magnitude; zero for zero *
+     **************************************************************/
+    ULONG bitLength() const
+    {
+	ULONG bits = (this->magnitude.size() - 1) * BitsPerChunk;
+	CHUNK top = this->magnitude.back();
+
+	while (top) {
+	    ++bits;
+	    top >>= 1;
+	}
+	return bits;
+    }
+
+    /*****************************************************************
+     * raw magnitude bytes, without the sign, in the requested order *
+     * no leading zero bytes are produced; zero has no bytes at all  *
+     *****************************************************************/
+    enum ByteOrder {
+	BigEndian,
+	LittleEndian
+    };
+
+    std::vector<unsigned char> toBytes(ByteOrder order = BigEndian) const
+    {
+	ULONG numBytes = (bitLength() + BitsPerByte - 1) / BitsPerByte;
+	std::vector<unsigned char> bytes(numBytes);
+	ULONG i;
+
+	for (i = 0; i < numBytes; ++i) {
+	    unsigned char byte = (unsigned char)
+		(this->magnitude[i / sizeof(CHUNK)]
+		    >> ((i % sizeof(CHUNK)) * BitsPerByte));
+	    if (order == LittleEndian)
+		bytes[i] = byte;
+	    else
+		bytes[numBytes - 1 - i] = byte;
+	}
+	return bytes;
+    }
+
+    static BigInteger fromBytes(const unsigned char *bytes, size_t length,
+				ByteOrder order = BigEndian,
+				bool negative = false)
+    {
+	BigInteger answer;
+	size_t i;
+
+	answer.magnitude.assign((length + sizeof(CHUNK) - 1) / sizeof(CHUNK)
+				    + 1, 0);
+	for (i = 0; i < length; ++i) {
+	    CHUNK byte = (order == LittleEndian) ? bytes[i]
+						 : bytes[length - 1 - i];
+	    answer.magnitude[i / sizeof(CHUNK)]
+		|= byte << ((i % sizeof(CHUNK)) * BitsPerByte);
+	}
+	answer.sign = negative ? Negative : Positive;
+	answer.popLeadingZeros();
+	return answer;
+    }
+
+    static BigInteger fromBytes(const std::vector<unsigned char> &bytes,
+				ByteOrder order = BigEndian,
+				bool negative = false)
+    {
+	return fromBytes(bytes.empty() ? 0 : &bytes[0], bytes.size(),
+			 order, negative);
+    }
+
+    /****************************************************************
+     * random values, drawn a whole limb at a time from source      *
+     * random(bits) is uniform in [0, 2^bits); randomOfLength(bits) *
+     * has exactly that many bits, i.e. the top one is always set,  *
+     * as prime candidates need; randomBelow(bound) is uniform in   *
+     * [0, bound), by rejection: a draw of bound's bit length is    *
+     * below bound at least half the time                           *
+     ****************************************************************/
+    static BigInteger random(ULONG bits,
+			     RandomSource &source = defaultRandomSource())
+    {
+	BigInteger answer;
+
+	randomMagnitude(bits, source, answer.magnitude);
+	return answer;
+    }
+
+    static BigInteger randomOfLength(ULONG bits,
+				     RandomSource &source
+					 = defaultRandomSource())
+    {
+	BigInteger answer;
+
+	if (bits == 0)
+	    throw("bit length must be positive");
+	randomMagnitude(bits, source, answer.magnitude);
+	answer.magnitude.resize((bits + BitsPerChunk - 1) / BitsPerChunk, 0);
+	answer.magnitude.back() |= LOW_BIT << ((bits - 1) % BitsPerChunk);
+	return answer;
+    }
+
+    static BigInteger randomBelow(const BigInteger &bound,
+				  RandomSource &source = defaultRandomSource())
+    {
+	BigInteger answer;
+	ULONG bits = bound.bitLength();
+
+	if (bound.sign == Negative || bits == 0)
+	    throw("bound must be positive");
+	do
+	    randomMagnitude(bits, source, answer.magnitude);
+	while (compareMagnitudes(answer.magnitude, bound.magnitude) >= 0);
+	return answer;
+    }
+
+    /**********************************************************************
+     * binary serialization                                               *
+     * fixed format (version 1), 16 byte header then the limbs:           *
+     *     byte 0       SerialFixed                                       *
+     *     byte 1       0 positive, 1 negative                            *
+     *     bytes 2-7    zero                                              *
+     *     bytes 8-15   bit length, little-endian                         *
+     *     then (bit length + 63) / 64 limbs, 8 little-endian bytes each  *
+     * the limbs start 8-byte aligned relative to the buffer, so a        *
+     * BigIntegerView or a mapped file can use them in place              *
+     * compact format (version 2), for small values:                      *
+     *     byte 0       SerialCompact                                     *
+     *     varint       bit length * 2 + sign, 7 bits per byte, low first *
+     *     then (bit length + 7) / 8 magnitude bytes, little-endian       *
+     **********************************************************************/
+    static const unsigned char SerialFixed = 1;
+    static const unsigned char SerialCompact = 2;
+    static const size_t SerialHeaderSize = 16;
+
+    size_t serializedSize(bool compact = false) const
+    {
+	ULONG bits = bitLength();
+
+	if (!compact)
+	    return SerialHeaderSize
+		+ (bits + BitsPerChunk - 1) / BitsPerChunk * sizeof(CHUNK);
+
+	ULONG header = bits * 2 + 1;
+	size_t size = 1 + (bits + BitsPerByte - 1) / BitsPerByte;
+	for (; header; header >>= 7)
+	    ++size;
+	return size;
+    }
+
+    /******************************************************************
+     * write into a caller-supplied buffer of at least serializedSize *
+     * bytes; returns the number of bytes written                     *
+     ******************************************************************/
+    size_t serializeTo(unsigned char *buffer, bool compact = false) const
+    {
+	ULONG bits = bitLength();
+	unsigned char *out = buffer;
+	ULONG i;
+
+	if (compact) {
+	    ULONG header = bits * 2 + (this->sign == Negative ? 1 : 0);
+	    ULONG numBytes = (bits + BitsPerByte - 1) / BitsPerByte;
+
+	    *out++ = SerialCompact;
+	    do {
+		unsigned char byte = header & 0x7f;
+		header >>= 7;
+		*out++ = header ? (byte | 0x80) : byte;
+	    } while (header);
+	    for (i = 0; i < numBytes; ++i)
+		*out++ = (unsigned char) (this->magnitude[i / sizeof(CHUNK)]
+		    >> ((i % sizeof(CHUNK)) * BitsPerByte));
+	    return out - buffer;
+	}
+
+	ULONG numLimbs = (bits + BitsPerChunk - 1) / BitsPerChunk;
+
+	out[0] = SerialFixed;
+	out[1] = (this->sign == Negative) ? 1 : 0;
+	for (i = 2; i < 8; ++i)
+	    out[i] = 0;
+	storeLittleEndian(out + 8, bits);
+	out += SerialHeaderSize;
+	for (i = 0; i < numLimbs; ++i, out += sizeof(CHUNK))
+	    storeLittleEndian(out, this->magnitude[i]);
+	return out - buffer;
+    }
+
+    std::vector<unsigned char> serialize(bool compact = false) const
+    {
+	std::vector<unsigned char> buffer(serializedSize(compact));
+
+	serializeTo(&buffer[0], compact);
+	return buffer;
+    }
+
+    /************************************************************
+     * read either format; if 'used' is given, it is set to the *
+     * number of bytes consumed so that values can be packed    *
+     * one after another                                        *
+     ************************************************************/
+    static BigInteger deserialize(const unsigned char *buffer, size_t length,
+				  size_t *used = 0)
+    {
+	BigInteger answer;
+	const unsigned char *in = buffer;
+	const unsigned char *end = buffer + length;
+	ULONG bits, i;
+	bool negative;
+
+	if (length == 0)
+	    throw("truncated BigInteger data");
+
+	if (buffer[0] == SerialFixed) {
+	    if (length < SerialHeaderSize)
+		throw("truncated BigInteger data");
+	    if (buffer[1] > 1)
+		throw("malformed BigInteger data");
+	    for (i = 2; i < 8; ++i)	// reserved for later versions
+		if (buffer[i])
+		    throw("malformed BigInteger data");
+	    negative = buffer[1] == 1;
+	    bits = loadLittleEndian(buffer + 8);
+	    in += SerialHeaderSize;
+
+	    // rounded up without bits + 63, which wraps for a hostile header
+	    ULONG numLimbs = bits / BitsPerChunk + (bits % BitsPerChunk != 0);
+	    if (numLimbs > (ULONG) (end - in) / sizeof(CHUNK))
+		throw("truncated BigInteger data");
+	    if (numLimbs > 0)
+		answer.magnitude.resize(numLimbs);
+	    for (i = 0; i < numLimbs; ++i, in += sizeof(CHUNK))
+		answer.magnitude[i] = loadLittleEndian(in);
+	} else if (buffer[0] == SerialCompact) {
+	    ULONG header = 0;
+	    unsigned shift = 0;
+	    unsigned char byte;
+
+	    ++in;
+	    do {
+		if (in == end || shift >= BitsPerChunk)
+		    throw("truncated BigInteger data");
+		byte = *in++;
+		header |= (CHUNK) (byte & 0x7f) << shift;
+		shift += 7;
+	    } while (byte & 0x80);
+	    negative = header & 1;
+	    bits = header >> 1;
+
+	    ULONG numBytes = (bits + BitsPerByte - 1) / BitsPerByte;
+	    if (numBytes > (ULONG) (end - in))
+		throw("truncated BigInteger data");
+	    answer = fromBytes(in, numBytes, LittleEndian);
+	    in += numBytes;
+	} else
+	    throw("unknown BigInteger format");
+
+	// reject anything that would not round trip
+	if (answer.bitLength() != bits || (negative && bits == 0))
+	    throw("malformed BigInteger data");
+	answer.sign = negative ? Negative : Positive;
+
+	if (used)
+	    *used = in - buffer;
+	return answer;
+    }
+
+    static BigInteger deserialize(const std::vector<unsigned char> &buffer)
+    {
+	return deserialize(buffer.empty() ? 0 : &buffer[0], buffer.size());
+    }
+
+    /*******************************************************************
+     * streaming output                                                *
+     * Digits are handed to 'sink' in order, a block at a time, while  *
+     * the conversion is still running; the whole digit string is      *
+     * never held in memory.  Any radix from 2 to 36 is accepted.      *
+     * withSuffix adds the "BI" and limb count that operator<< writes. *
+     *******************************************************************/
+    typedef std::function<void (const char *, size_t)> DigitSink;
+
+    void writeTo(const DigitSink &sink, int radix = 10,
+		 bool withSuffix = false, bool uppercase = false) const
+    {
+	static const char lowerDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+	static const char upperDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	const char *digitChars = uppercase ? upperDigits : lowerDigits;
+	DigitBuffer out(sink, radix < 2 ? 0
+			      : (ULONG) (bitLength() * std::log(2.0)
+					 / std::log((double) radix)));
+	BIGINT_SPAN(OpPrint, this->magnitude.size());
+
+	if (radix < 2 || radix > 36)
+	    throw("unsupported radix");
+
+	if (this->sign == Negative)
+	    out.put('-');
+
+	unsigned bitsPerDigit = 0;
+	while ((1 << bitsPerDigit) < radix)
+	    ++bitsPerDigit;
+
+	if (isZero(*this)) {
+	    BIGINT_TIER(TierTrivial);
+	    out.put('0');
+	} else if ((1 << bitsPerDigit) == radix) {
+	    BIGINT_TIER(TierLinear);
+	    writePowerOfTwoDigits(out, bitsPerDigit, digitChars);
+	} else {
+	    BIGINT_TIER(TierDivideAndConquer);
+	    // the largest power of radix that fits in a CHUNK
+	    CHUNK chunkBase = radix;
+	    unsigned digitsPerChunk = 1;
+	    while (chunkBase <= ~(CHUNK) 0 / radix) {
+		chunkBase *= radix;
+		++digitsPerChunk;
+	    }
+
+	    // powers[k] = chunkBase^(2^k), up to the square root of *this
+	    std::vector<std::vector<CHUNK> > powers(1,
+					 std::vector<CHUNK>(1, chunkBase));
+	    std::vector<CHUNK> square;
+	    while (powers.back().size() * 2 <= this->magnitude.size() + 1) {
+		squareMagnitude(powers.back(), square);
+		if (compareMagnitudes(square, this->magnitude) > 0)
+		    break;
+		powers.push_back(square);
+	    }
+
+	    std::vector<CHUNK> value(this->magnitude);
+	    int level = powers.size() - 1;
+	    BIGINT_HELD((powers.back().size() * 2 + value.size())
+			     * sizeof(CHUNK));
+	    if (compareMagnitudes(value, powers[0]) < 0)
+		level = -1;
+	    writeChunks(value, level, false, powers, radix, digitsPerChunk,
+			out, digitChars);
+	}
+
+	if (withSuffix) {
+	    out.put('B');
+	    out.put('I');
+	}
+	out.flush();
+
+	// for debugging, show number of CHUNKs needed to store value
+	if (withSuffix && this->magnitude.size() > 1) {
+	    std::string count = std::to_string(this->magnitude.size());
+	    sink(count.data(), count.size());
+	}
+    }
+
+    /*************************************************************
+     * write to a stream, in the radix and case its flags select *
+     *************************************************************/
+    void writeTo(std::ostream &strm, bool withSuffix = false) const
+    {
+	int radix = 10;
+
+	if (strm.flags() & std::ios::hex)
+	    radix = 16;
+	else if (strm.flags() & std::ios::oct)
+	    radix = 8;
+
+	writeTo([&strm](const char *digits, size_t length)
+		{ strm.write(digits, length); },
+		radix, false, (strm.flags() & std::ios::uppercase) != 0);
+
+	if (withSuffix) {
+	    strm << "BI";	// denote a big integer
+
+	    // for debugging, show number of CHUNKs needed to store value
+	    if (this->magnitude.size() > 1)
+		strm << this->magnitude.size();
+	}
+    }
+};
+
+// stream input and output
+inline std::ostream& operator<< (std::ostream &strm, BigInteger bigI)
+{
+    bigI.printOn(strm);
+    return strm;
+}
+
+
+inline std::istream& operator>> (std::istream &strm, BigInteger &bigI)
+{
+    bigI.readFrom(strm);
+    return strm;
+}
+
+/**************************************************************
+ * hashing: std::hash<BigInteger> uses seed 0; BigIntegerHash *
+ * carries its own seed, for tables that take untrusted keys  *
+ **************************************************************/
+namespace std {
+template <> struct hash<BigInteger> {
+    size_t operator() (const BigInteger &value) const
+    {
+	return (size_t) value.hash();
+    }
+};
+}
+
+struct BigIntegerHash {
+    ULONG seed;
+
+    explicit BigIntegerHash(ULONG seedArg = 0) :seed(seedArg)
+    {
+    }
+
+    size_t operator() (const BigInteger &value) const
+    {
+	return (size_t) value.hash(seed);
+    }
+};
+
+/***************************************************************
+ * a BigInteger paired with its hash, computed once; use it as *
+ * the key when the same long values are looked up repeatedly  *
+ ***************************************************************/
+class HashedBigInteger
+{
+    private:
+    BigInteger value;
+    ULONG hashValue;
+
+    public:
+    HashedBigInteger(const BigInteger &valueArg, ULONG seed = 0)
+	:value(valueArg), hashValue(valueArg.hash(seed))
+    {
+    }
+
+    const BigInteger &bigInteger() const
+    {
+	return this->value;
+    }
+
+    ULONG hash() const
+    {
+	return this->hashValue;
+    }
+
+    bool operator== (const HashedBigInteger &other) const
+    {
+	return this->hashValue == other.hashValue && this->value == other.value;
+    }
+
+    bool operator!= (const HashedBigInteger &other) const
+    {
+	return !(*this == other);
+    }
+};
+
+namespace std {
+template <> struct hash<HashedBigInteger> {
+    size_t operator() (const HashedBigInteger &value) const
+    {
+	return (size_t) value.hash();
+    }
+};
+}
+
+/*****************************************************************
+ * hash-consing: the one shared copy of value, which stays valid *
+ * for the life of the program.  Small constants come from       *
+ * BigInteger::smallConstant without taking the lock             *
+ *****************************************************************/
+inline const BigInteger &intern(const BigInteger &value)
+{
+    static std::mutex lock;
+    static std::unordered_set<BigInteger> table;
+
+    const BigInteger *small = BigInteger::findSmallConstant(value);
+
+    if (small)
+	return *small;
+
+    std::lock_guard<std::mutex> guard(lock);
+    return *table.insert(value).first;
+}
+
+/*******************************************************************
+ * a BigInteger whose limbs are held in reference-counted storage, *
+ * so that copying one (to a logger, into a second container, out  *
+ * of a function) costs an atomic increment however large it is.   *
+ * The storage is never changed while it is shared: the compound   *
+ * operators build their result in fresh storage when other copies *
+ * exist, and reuse the storage only when this is the last one.    *
+ * As with shared_ptr, distinct SharedBigIntegers may be used from *
+ * any number of threads at once, even when they share storage;    *
+ * one SharedBigInteger must not be assigned to while other        *
+ * threads read it.                                                *
+ *******************************************************************/
+class SharedBigInteger
+{
+    private:
+    std::shared_ptr<BigInteger> value;
+
+    static const std::shared_ptr<BigInteger> &sharedZero()
+    {
+	static const std::shared_ptr<BigInteger> zero =
+	    std::make_shared<BigInteger>(0);
+
+	return zero;
+    }
+
+    /****************************************************************
+     * the last copy may reuse its storage; the acquire fence pairs *
+     * with the release in the other copies' destructors, so their  *
+     * reads are finished before the limbs are overwritten          *
+     ****************************************************************/
+    bool isUnique() const
+    {
+	if (this->value.use_count() != 1)
+	    return false;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return true;
+    }
+
+    // make result the value, moving its limbs rather than copying them
+    void replace(BigInteger &result)
+    {
+	if (!isUnique())
+	    this->value = std::make_shared<BigInteger>();
+	this->value->magnitude.swap(result.magnitude);
+	this->value->sign = result.sign;
+    }
+
+    public:
+    SharedBigInteger() :value(sharedZero())
+    {
+    }
+
+    SharedBigInteger(const BigInteger &valueArg)
+	:value(std::make_shared<BigInteger>(valueArg))
+    {
+    }
+
+    /**************************************************************
+     * take over the limbs of result, leaving it zero, so a large *
+     * result becomes shared without being copied even once       *
+     **************************************************************/
+    static SharedBigInteger adopt(BigInteger &result)
+    {
+	SharedBigInteger answer;
+
+	answer.replace(result);
+	result = BigInteger::smallConstant(0);
+	return answer;
+    }
+
+    const BigInteger &get() const
+    {
+	return *this->value;
+    }
+
+    operator const BigInteger &() const
+    {
+	return *this->value;
+    }
+
+    // number of SharedBigIntegers using this storage
+    long useCount() const
+    {
+	return this->value.use_count();
+    }
+
+    bool sharesStorageWith(const SharedBigInteger &other) const
+    {
+	return this->value == other.value;
+    }
+
+    /*************
+     * Operators *
+     *************/
+    SharedBigInteger& operator+= (const BigInteger &other)
+    {
+	BigInteger result = *this->value + other;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger& operator-= (const BigInteger &other)
+    {
+	BigInteger result = *this->value - other;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger& operator*= (const BigInteger &other)
+    {
+	BigInteger result = *this->value * other;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger& operator/= (const BigInteger &other)
+    {
+	BigInteger result = *this->value / other;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger& operator%= (const BigInteger &other)
+    {
+	BigInteger result = *this->value % other;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger& operator<<= (const BigInteger &shiftAmount)
+    {
+	BigInteger result = *this->value << shiftAmount;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger& operator>>= (const BigInteger &shiftAmount)
+    {
+	BigInteger result = *this->value >> shiftAmount;
+
+	replace(result);
+	return *this;
+    }
+
+    SharedBigInteger operator+ (const BigInteger &other) const
+    {
+	BigInteger result = *this->value + other;
+
+	return adopt(result);
+    }
+
+    SharedBigInteger operator- (const BigInteger &other) const
+    {
+	BigInteger result = *this->value - other;
+
+	return adopt(result);
+    }
+
+    SharedBigInteger operator* (const BigInteger &other) const
+    {
+	BigInteger result = *this->value * other;
+
+	return adopt(result);
+    }
+
+    SharedBigInteger operator/ (const BigInteger &other) const
+    {
+	BigInteger result = *this->value / other;
+
+	return adopt(result);
+    }
+
+    SharedBigInteger operator% (const BigInteger &other) const
+    {
+	BigInteger result = *this->value % other;
+
+	return adopt(result);
+    }
+
+    // Unary minus operator
+    SharedBigInteger operator- () const
+    {
+	BigInteger result = -*this->value;
+
+	return adopt(result);
+    }
+
+    // copies that share storage are equal without looking at the limbs
+    bool operator== (const BigInteger &other) const
+    {
+	return this->value.get() == &other || *this->value == other;
+    }
+
+    bool operator!= (const BigInteger &other) const
+    {
+	return !(*this == other);
+    }
+
+    bool operator< (const BigInteger &other) const
+    {
+	return *this->value < other;
+    }
+
+    bool operator> (const BigInteger &other) const
+    {
+	return *this->value > other;
+    }
+
+    bool operator<= (const BigInteger &other) const
+    {
+	return *this->value <= other;
+    }
+
+    bool operator>= (const BigInteger &other) const
+    {
+	return *this->value >= other;
+    }
+};
+
+inline std::ostream& operator<< (std::ostream &strm,
+				 const SharedBigInteger &value)
+{
+    value.get().writeTo(strm);
+    return strm;
+}
+
+namespace std {
+template <> struct hash<SharedBigInteger> {
+    size_t operator() (const SharedBigInteger &value) const
+    {
+	return (size_t) value.get().hash();
+    }
+};
+}
+
+// base raised to exponent; see BigInteger::pow
+inline BigInteger pow(const BigInteger &base, const BigInteger &exponent)
+{
+    return base.pow(exponent);
+}
+
+/*******************************************************************
+ * powers of one fixed base, for code that raises the same base to *
+ * many exponents: the squarings base^(2^k) are done once, up      *
+ * front, so each pow() is only a product of the table entries     *
+ * picked out by the exponent's bits.  Entry k is 2^k times the    *
+ * size of the base, so maxExponentBits should cover the exponents *
+ * actually expected and no more.  Like BigInteger::pow, the power *
+ * of two in the base is kept apart and applied as a shift         *
+ *******************************************************************/
+class FixedBasePow
+{
+    private:
+    BigInteger baseValue;
+    std::vector<std::vector<CHUNK> > powers;	// odd part ^ (2^k)
+    ULONG twos;		// the base is (odd part) * 2^twos
+
+    public:
+    explicit FixedBasePow(const BigInteger &base, ULONG maxExponentBits = 16)
+	:baseValue(base), twos(0)
+    {
+	std::vector<CHUNK> odd(base.magnitude);
+	ULONG k;
+
+	if (odd.size() == 1 && odd[0] <= 1)
+	    return;	// pow() is trivial; leave the table empty
+	twos = BigInteger::trailingZeroBits(odd);
+	BigInteger::shiftMagnitudeRight(odd, twos);
+	powers.push_back(odd);
+	for (k = 1; k < maxExponentBits && k < BigInteger::BitsPerChunk; ++k) {
+	    std::vector<CHUNK> square;
+
+	    BigInteger::squareMagnitude(powers.back(), square);
+	    powers.push_back(square);
+	}
+    }
+
+    const BigInteger &base() const
+    {
+	return this->baseValue;
+    }
+
+    /***********************************************************
+     * base^exponent; bits beyond the table still work, at the *
+     * cost of squaring the last entry again for each          *
+     ***********************************************************/
+    BigInteger pow(const BigInteger &exponent) const
+    {
+	BigInteger answer;
+	std::vector<CHUNK> product, extra, scratch;
+	ULONG k;
+
+	if (powers.empty() || exponent.sign == BigInteger::Negative
+		|| exponent.magnitude.size() > 1)
+	    return baseValue.pow(exponent);	// trivial cases and errors
+
+	ULONG power = exponent.magnitude[0];
+	if (twos && power > ~(ULONG) 0 / twos)
+	    throw("exponent too large");
+
+	answer.magnitude.assign(1, 1);
+	for (k = 0; k < BigInteger::BitsPerChunk && (power >> k); ++k) {
+	    const std::vector<CHUNK> *factor = &extra;
+
+	    if (k < powers.size())
+		factor = &powers[k];
+	    else {
+		if (k == powers.size())
+		    extra = powers.back();
+		BigInteger::squareMagnitude(extra, scratch);
+		extra.swap(scratch);
+	    }
+	    if ((power >> k) & 1) {
+		BigInteger::multiplyMagnitudes(answer.magnitude, *factor,
+					       product);
+		answer.magnitude.swap(product);
+	    }
+	}
+	BigInteger::shiftMagnitudeLeft(answer.magnitude, twos * power);
+	if (baseValue.sign == BigInteger::Negative && (power & 1))
+	    answer.sign = BigInteger::Negative;
+	return answer;
+    }
+};
+
+/*******************************************************************
+ * Asynchronous operations                                         *
+ * Each call starts the work on a thread of its own and returns a  *
+ * std::future for the result.  The work polls 'token' every few   *
+ * dozen rows of each multiplication or division and at each step  *
+ * of pow, printing and factorial; once the token is cancelled the *
+ * future's get() throws "operation cancelled".  'progress' is     *
+ * called on the worker thread with the fraction done so far, and  *
+ * with 1 when the result is ready.  Unlike the operators, which   *
+ * still work a bit at a time, these use the limb kernels.         *
+ *******************************************************************/
+class BigIntegerAsync
+{
+    private:
+    template <class Result, class Work>
+    static std::future<Result> launch(const CancellationToken &token,
+				      const ProgressCallback &progress,
+				      OperationControl::Reporter reporter,
+				      Work work)
+    {
+	return std::async(std::launch::async, [=]() -> Result
+	{
+	    OperationControl control(token, progress, reporter);
+
+	    OperationControl::poll(reporter, 0, 1);	// cancelled already?
+	    Result result = work();
+	    control.report(1.0);
+	    return result;
+	});
+    }
+
+    static BigInteger fromMagnitude(std::vector<CHUNK> &digits,
+				    bool negative)
+    {
+	BigInteger answer;
+
+	answer.magnitude.swap(digits);
+	BigInteger::trimMagnitude(answer.magnitude);
+	if (negative && (answer.magnitude.size() > 1 || answer.magnitude[0]))
+	    answer.sign = BigInteger::Negative;
+	return answer;
+    }
+
+    public:
+    static std::future<BigInteger> multiply(
+	const BigInteger &a, const BigInteger &b,
+	const CancellationToken &token = CancellationToken(),
+	const ProgressCallback &progress = ProgressCallback())
+    {
+	return launch<BigInteger>(token, progress,
+				  OperationControl::MultiplyRows, [a, b]()
+	{
+	    std::vector<CHUNK> product;
+
+	    if (a.magnitude == b.magnitude)
+		BigInteger::squareMagnitude(a.magnitude, product);
+	    else
+		BigInteger::multiplyMagnitudes(a.magnitude, b.magnitude,
+					       product);
+	    return fromMagnitude(product, a.sign != b.sign);
+	});
+    }
+
+    // quotient and remainder, with the signs that '/' and '%' give
+    static std::future<std::pair<BigInteger, BigInteger> > divide(
+	const BigInteger &dividend, const BigInteger &divisor,
+	const CancellationToken &token = CancellationToken(),
+	const ProgressCallback &progress = ProgressCallback())
+    {
+	return launch<std::pair<BigInteger, BigInteger> >(token, progress,
+	    OperationControl::DivideRows, [dividend, divisor]()
+	{
+	    std::vector<CHUNK> quotient, remainder;
+
+	    if (divisor.magnitude.size() == 1 && divisor.magnitude[0] == 0)
+		throw("divide by zero");
+	    BigInteger::divideMagnitudes(dividend.magnitude,
+					 divisor.magnitude,
+					 quotient, remainder);
+	    return std::make_pair(
+		fromMagnitude(quotient, dividend.sign != divisor.sign),
+		fromMagnitude(remainder, false));
+	});
+    }
+
+    static std::future<BigInteger> pow(
+	const BigInteger &base, const BigInteger &exponent,
+	const CancellationToken &token = CancellationToken(),
+	const ProgressCallback &progress = ProgressCallback())
+    {
+	return launch<BigInteger>(token, progress, OperationControl::PowBits,
+				  [base, exponent]()
+	{
+	    return base.pow(exponent);
+	});
+    }
+
+    // the digits of value in radix, as writeTo() produces them
+    static std::future<std::string> toString(
+	const BigInteger &value, int radix = 10,
+	const CancellationToken &token = CancellationToken(),
+	const ProgressCallback &progress = ProgressCallback())
+    {
+	return launch<std::string>(token, progress,
+				   OperationControl::PrintDigits,
+				   [value, radix]()
+	{
+	    std::string digits;
+
+	    value.writeTo([&digits](const char *text, size_t length)
+			  { digits.append(text, length); }, radix);
+	    return digits;
+	});
+    }
+
+    static std::future<BigInteger> factorial(
+	ULONG n,
+	const CancellationToken &token = CancellationToken(),
+	const ProgressCallback &progress = ProgressCallback())
+    {
+	return launch<BigInteger>(token, progress,
+				  OperationControl::FactorialFactors, [n]()
+	{
+	    return BigInteger::factorial(n);
+	});
+    }
+};
+
+/******************************************************************
+ * Deferred-carry accumulator for summing many BigIntegers        *
+ * Each limb position counts the carries out of it instead of     *
+ * propagating them, so an add or multiply-add touches only the   *
+ * limbs of its operands.  Positive and negative contributions    *
+ * are kept apart and only combined when the result is requested. *
+ ******************************************************************/
+class BigAccumulator
+{
+    private:
+    enum Part {
+	PositivePart,
+	NegativePart,
+	NumParts
+    };
+
+    std::vector<CHUNK> sum[NumParts];		// low 64 bits per limb
+    std::vector<CHUNK> carries[NumParts];	// pending carries out of limb
+
+    // how many more carries any one limb can take before overflowing
+    ULONG carryHeadroom;
+
+    /***********************************************************
+     * make room for an operand (or product) of 'limbs' limbs, *
+     * normalizing first if its carries might overflow a limb  *
+     ***********************************************************/
+    void prepare(ULONG limbs, ULONG maxCarriesPerLimb)
+    {
+	int part;
+
+	if (maxCarriesPerLimb > carryHeadroom) {
+	    normalize();
+	    if (maxCarriesPerLimb > carryHeadroom)
+		throw("accumulator operand too large");
+	}
+	carryHeadroom -= maxCarriesPerLimb;
+
+	for (part = 0; part < NumParts; ++part)
+	    if (sum[part].size() < limbs) {
+		sum[part].resize(limbs, 0);
+		carries[part].resize(limbs, 0);
+	    }
+    }
+
+    /****************************************************
+     * add one CHUNK at a limb position, noting a carry *
+     ****************************************************/
+    void addChunk(std::vector<CHUNK> &digits, std::vector<CHUNK> &carry,
+		  ULONG position, CHUNK value)
+    {
+	CHUNK digit = digits[position] + value;
+
+	carry[position] += (digit < value);	// 0(false) or 1(true)
+	digits[position] = digit;
+    }
+
+    /*******************************************************
+     * propagate all pending carries into the limbs proper *
+     *******************************************************/
+    void normalize()
+    {
+	int part;
+	ULONG i;
+
+	for (part = 0; part < NumParts; ++part) {
+	    std::vector<CHUNK> &digits = sum[part];
+	    std::vector<CHUNK> &carry = carries[part];
+	    CHUNK inCarry = 0;
+
+	    for (i = 0; i < digits.size(); ++i) {
+		CHUNK digit = digits[i] + inCarry;
+		CHUNK outCarry = carry[i] + (digit < inCarry);
+
+		digits[i] = digit;
+		carry[i] = 0;
+		inCarry = outCarry;
+	    }
+
+	    if (inCarry) {	// grow the accumulator
+		digits.push_back(inCarry);
+		carry.push_back(0);
+	    }
+	}
+
+	carryHeadroom = ~(CHUNK) 0;
+    }
+
+    public:
+    /**************************************************************
+     * initialLimbs only pre-sizes the buffer; it grows as needed *
+     **************************************************************/
+    BigAccumulator(ULONG initialLimbs = 4) :carryHeadroom(~(CHUNK) 0)
+    {
+	int part;
+
+	for (part = 0; part < NumParts; ++part) {
+	    sum[part].resize(initialLimbs ? initialLimbs : 1, 0);
+	    carries[part].resize(sum[part].size(), 0);
+	}
+    }
+
+    /*************************
+     * start again from zero *
+     *************************/
+    void clear()
+    {
+	int part;
+
+	for (part = 0; part < NumParts; ++part) {
+	    sum[part].assign(sum[part].size(), 0);
+	    carries[part].assign(carries[part].size(), 0);
+	}
+	carryHeadroom = ~(CHUNK) 0;
+    }
+
+    /************************************
+     * add (or subtract) a signed value *
+     ************************************/
+    void add(const BigInteger &value)
+    {
+	int part = value.sign == BigInteger::Negative ? NegativePart
+						      : PositivePart;
+	ULONG i;
+
+	prepare(value.magnitude.size(), 1);
+	for (i = 0; i < value.magnitude.size(); ++i)
+	    addChunk(sum[part], carries[part], i, value.magnitude[i]);
+    }
+
+    void subtract(const BigInteger &value)
+    {
+	int part = value.sign == BigInteger::Negative ? PositivePart
+						      : NegativePart;
+	ULONG i;
+
+	prepare(value.magnitude.size(), 1);
+	for (i = 0; i < value.magnitude.size(); ++i)
+	    addChunk(sum[part], carries[part], i, value.magnitude[i]);
+    }
+
+    BigAccumulator& operator+= (const BigInteger &value)
+    {
+	add(value);
+	return *this;
+    }
+
+    BigAccumulator& operator-= (const BigInteger &value)
+    {
+	subtract(value);
+	return *this;
+    }
+
+    /**************************************************************
+     * multiply-accumulate: add a * b without forming the product *
+     * each partial product lands directly in its limb positions  *
+     **************************************************************/
+    void addProduct(const BigInteger &a, const BigInteger &b)
+    {
+	int part = a.sign == b.sign ? PositivePart : NegativePart;
+	ULONG aSize = a.magnitude.size();
+	ULONG bSize = b.magnitude.size();
+	ULONG i, j;
+
+	// limb i+j receives one low half and one high half per pair
+	prepare(aSize + bSize, 2 * (aSize < bSize ? aSize : bSize));
+
+	std::vector<CHUNK> &digits = sum[part];
+	std::vector<CHUNK> &carry = carries[part];
+
+	for (i = 0; i < aSize; ++i) {
+	    CHUNK aDigit = a.magnitude[i];
+
+	    if (aDigit == 0)
+		continue;
+	    for (j = 0; j < bSize; ++j) {
+		CHUNK high;
+		CHUNK low = mulChunks(aDigit, b.magnitude[j], high);
+
+		addChunk(digits, carry, i + j, low);
+		addChunk(digits, carry, i + j + 1, high);
+	    }
+	}
+    }
+
+    /***************************************************************
+     * propagate the deferred carries and return the signed total  *
+     * the accumulator keeps its value and can continue to be used *
+     ***************************************************************/
+    BigInteger result()
+    {
+	BigInteger positive, negative;
+
+	normalize();
+
+	positive.magnitude = sum[PositivePart];
+	positive.popLeadingZeros();
+	negative.magnitude = sum[NegativePart];
+	negative.popLeadingZeros();
+
+	return positive - negative;
+    }
+};
+
+/******************************************************************
+ * Non-owning view of a BigInteger in the fixed serialized format *
+ * Limbs are read straight out of the buffer, so values held in a *
+ * cache or received over the wire can be compared and used in    *
+ * arithmetic without first being copied into a BigInteger.       *
+ * The buffer must outlive the view.                              *
+ ******************************************************************/
+class BigIntegerView
+{
+    private:
+    const unsigned char *limbData;
+    ULONG numLimbs;
+    ULONG bits;
+    bool negative;
+
+    // limb access shared by views and BigIntegers in the routines below
+    struct ViewLimbs {
+	const unsigned char *data;
+	ULONG count;
+
+	CHUNK operator[] (ULONG i) const
+	{
+	    return loadLittleEndian(data + i * sizeof(CHUNK));
+	}
+    };
+
+    struct MagnitudeLimbs {
+	const CHUNK *data;
+	ULONG count;	// zero for a zero value, like a view
+
+	CHUNK operator[] (ULONG i) const
+	{
+	    return data[i];
+	}
+    };
+
+    ViewLimbs limbs() const
+    {
+	ViewLimbs answer = { limbData, numLimbs };
+	return answer;
+    }
+
+    static MagnitudeLimbs limbs(const BigInteger &value)
+    {
+	MagnitudeLimbs answer = { &value.magnitude[0],
+				  value.isZero(value)
+				      ? 0 : (ULONG) value.magnitude.size() };
+	return answer;
+    }
+
+    /*************************************************
+     * compare two normalized magnitudes: -1, 0 or 1 *
+     *************************************************/
+    template <class A, class B>
+    static int compareMagnitude(const A &a, const B &b)
+    {
+	ULONG index;
+
+	if (a.count != b.count)
+	    return a.count < b.count ? -1 : 1;
+	for (index = a.count; index > 0; --index) {
+	    CHUNK aDigit = a[index - 1];
+	    CHUNK bDigit = b[index - 1];
+	    if (aDigit != bDigit)
+		return aDigit < bDigit ? -1 : 1;
+	}
+	return 0;
+    }
+
+    /***************************************************************
+     * a + b, or a - b when 'subtract' is set, for signed operands *
+     ***************************************************************/
+    template <class A, class B>
+    static BigInteger addSigned(const A &a, bool aNegative,
+				const B &b, bool bNegative, bool subtract)
+    {
+	BigInteger answer;
+	ULONG i;
+
+	if (subtract)
+	    bNegative = !bNegative;
+
+	if (aNegative == bNegative) {	// add magnitudes
+	    ULONG size = a.count > b.count ? a.count : b.count;
+	    CHUNK carry = 0;
+
+	    answer.magnitude.resize(size + 1);
+	    for (i = 0; i < size; ++i) {
+		CHUNK aDigit = i < a.count ? a[i] : 0;
+		CHUNK bDigit = i < b.count ? b[i] : 0;
+		CHUNK digit = aDigit + bDigit;
+		CHUNK outCarry = digit < aDigit;
+
+		digit += carry;
+		outCarry |= digit < carry;
+		answer.magnitude[i] = digit;
+		carry = outCarry;
+	    }
+	    answer.magnitude[size] = carry;
+	    answer.sign = aNegative ? BigInteger::Negative
+				    : BigInteger::Positive;
+	} else {	// subtract the smaller magnitude from the larger
+	    int order = compareMagnitude(a, b);
+
+	    if (order == 0)
+		return answer;
+	    if (order < 0)
+		return addSigned(b, bNegative, a, aNegative, false);
+
+	    CHUNK borrow = 0;
+
+	    answer.magnitude.resize(a.count);
+	    for (i = 0; i < a.count; ++i) {
+		CHUNK aDigit = a[i];
+		CHUNK bDigit = i < b.count ? b[i] : 0;
+		CHUNK digit = aDigit - bDigit;
+		CHUNK outBorrow = aDigit < bDigit;
+
+		outBorrow |= digit < borrow;
+		answer.magnitude[i] = digit - borrow;
+		borrow = outBorrow;
+	    }
+	    answer.sign = aNegative ? BigInteger::Negative
+				    : BigInteger::Positive;
+	}
+
+	answer.popLeadingZeros();
+	return answer;
+    }
+
+    /****************************************
+     * schoolbook product of two magnitudes *
+     ****************************************/
+    template <class A, class B>
+    static BigInteger multiply(const A &a, bool aNegative,
+			       const B &b, bool bNegative)
+    {
+	BigInteger answer;
+	ULONG i, j;
+
+	if (a.count == 0 || b.count == 0)
+	    return answer;
+
+	answer.magnitude.assign(a.count + b.count, 0);
+	for (i = 0; i < a.count; ++i) {
+	    CHUNK aDigit = a[i];
+	    CHUNK carry = 0;
+
+	    for (j = 0; j < b.count; ++j) {
+		CHUNK high;
+		CHUNK low = mulChunks(aDigit, b[j], high);
+
+		low += carry;
+		high += low < carry;
+		low += answer.magnitude[i + j];
+		high += low < answer.magnitude[i + j];
+		answer.magnitude[i + j] = low;
+		carry = high;
+	    }
+	    answer.magnitude[i + b.count] = carry;
+	}
+	answer.sign = aNegative == bNegative ? BigInteger::Positive
+					     : BigInteger::Negative;
+	answer.popLeadingZeros();
+	return answer;
+    }
+
+    public:
+    /****************************************************
+     * view a buffer written by BigInteger::serialize() *
+     * only the fixed format can be viewed in place     *
+     ****************************************************/
+    BigIntegerView(const unsigned char *buffer, size_t length)
+    {
+	unsigned i;
+
+	if (length < BigInteger::SerialHeaderSize)
+	    throw("truncated BigInteger data");
+	if (buffer[0] != BigInteger::SerialFixed || buffer[1] > 1)
+	    throw("not a fixed format BigInteger");
+	for (i = 2; i < 8; ++i)	// reserved for later versions
+	    if (buffer[i])
+		throw("malformed BigInteger data");
+
+	negative = buffer[1] == 1;
+	bits = loadLittleEndian(buffer + 8);
+	numLimbs = bits / BigInteger::BitsPerChunk	// bits + 63 could wrap
+		   + (bits % BigInteger::BitsPerChunk != 0);
+	limbData = buffer + BigInteger::SerialHeaderSize;
+
+	if (numLimbs > (length - BigInteger::SerialHeaderSize) / sizeof(CHUNK))
+	    throw("truncated BigInteger data");
+	if (numLimbs > 0 && (limb(numLimbs - 1)
+		>> ((bits - 1) % BigInteger::BitsPerChunk)) != 1)
+	    throw("malformed BigInteger data");
+	if (negative && bits == 0)
+	    throw("malformed BigInteger data");
+    }
+
+    BigIntegerView(const std::vector<unsigned char> &buffer)
+	:BigIntegerView(buffer.empty() ? 0 : &buffer[0], buffer.size())
+    {
+    }
+
+    bool isNegative() const
+    {
+	return negative;
+    }
+
+    bool isZero() const
+    {
+	return numLimbs == 0;
+    }
+
+    ULONG bitLength() const
+    {
+	return bits;
+    }
+
+    ULONG limbCount() const
+    {
+	return numLimbs;
+    }
+
+    CHUNK limb(ULONG i) const
+    {
+	return loadLittleEndian(limbData + i * sizeof(CHUNK));
+    }
+
+    // bytes of the buffer the value occupies
+    size_t size() const
+    {
+	return BigInteger::SerialHeaderSize + numLimbs * sizeof(CHUNK);
+    }
+
+    BigInteger toBigInteger() const
+    {
+	BigInteger answer;
+	ULONG i;
+
+	if (numLimbs > 0)
+	    answer.magnitude.resize(numLimbs);
+	for (i = 0; i < numLimbs; ++i)
+	    answer.magnitude[i] = limb(i);
+	answer.sign = negative ? BigInteger::Negative : BigInteger::Positive;
+	return answer;
+    }
+
+    /*******************************************************
+     * comparisons return -1, 0 or 1 like compareMagnitude *
+     *******************************************************/
+    int compare(const BigIntegerView &other) const
+    {
+	if (negative != other.negative)
+	    return negative ? -1 : 1;
+	int order = compareMagnitude(limbs(), other.limbs());
+	return negative ? -order : order;
+    }
+
+    int compare(const BigInteger &other) const
+    {
+	bool otherNegative = other.sign == BigInteger::Negative;
+
+	if (negative != otherNegative)
+	    return negative ? -1 : 1;
+	int order = compareMagnitude(limbs(), limbs(other));
+	return negative ? -order : order;
+    }
+
+    template <class T> bool operator== (const T &other) const
+    {
+	return compare(other) == 0;
+    }
+
+    template <class T> bool operator!= (const T &other) const
+    {
+	return compare(other) != 0;
+    }
+
+    template <class T> bool operator< (const T &other) const
+    {
+	return compare(other) < 0;
+    }
+
+    template <class T> bool operator<= (const T &other) const
+    {
+	return compare(other) <= 0;
+    }
+
+    template <class T> bool operator> (const T &other) const
+    {
+	return compare(other) > 0;
+    }
+
+    template <class T> bool operator>= (const T &other) const
+    {
+	return compare(other) >= 0;
+    }
+
+    /********************************************************
+     * arithmetic straight from the buffer; only the result *
+     * is allocated                                         *
+     ********************************************************/
+    BigInteger operator+ (const BigIntegerView &other) const
+    {
+	return addSigned(limbs(), negative,
+			 other.limbs(), other.negative, false);
+    }
+
+    BigInteger operator+ (const BigInteger &other) const
+    {
+	return addSigned(limbs(), negative, limbs(other),
+			 other.sign == BigInteger::Negative, false);
+    }
+
+    BigInteger operator- (const BigIntegerView &other) const
+    {
+	return addSigned(limbs(), negative,
+			 other.limbs(), other.negative, true);
+    }
+
+    BigInteger operator- (const BigInteger &other) const
+    {
+	return addSigned(limbs(), negative, limbs(other),
+			 other.sign == BigInteger::Negative, true);
+    }
+
+    BigInteger operator* (const BigIntegerView &other) const
+    {
+	return multiply(limbs(), negative, other.limbs(), other.negative);
+    }
+
+    BigInteger operator* (const BigInteger &other) const
+    {
+	return multiply(limbs(), negative, limbs(other),
+			other.sign == BigInteger::Negative);
+    }
+};
+
+/*******************************************************************
+ * BigInteger held in a memory-mapped file, for values too large   *
+ * for the heap                                                    *
+ * The file is exactly the fixed serialization format, followed by *
+ * spare limb capacity, so a checkpoint can be reloaded with       *
+ * BigInteger::deserialize() or viewed with BigIntegerView.        *
+ * The kernels below walk the limbs in order, a block at a time,   *
+ * so the operating system can page the file in and out behind     *
+ * them.  Only available where mmap() is.                          *
+ *******************************************************************/
+class MappedBigInteger
+{
+    private:
+    int fd;
+    unsigned char *base;	// start of the mapping
+    size_t mappedBytes;
+    ULONG numLimbs;		// limbs in use, per the header
+    bool negative;
+
+    // limbs handled together by the blocked kernels: 32KB per block
+    static const ULONG BlockLimbs = 4096;
+    // operand blocks for multiply, 512KB each, so Karatsuba pays off
+    static const ULONG MultiplyBlockLimbs = 65536;
+
+    unsigned char *limbAddress(ULONG i) const
+    {
+	return base + BigInteger::SerialHeaderSize + i * sizeof(CHUNK);
+    }
+
+    ULONG capacity() const
+    {
+	return (mappedBytes - BigInteger::SerialHeaderSize) / sizeof(CHUNK);
+    }
+
+    /***************************************************************
+     * map the first 'bytes' bytes of the file, replacing any      *
+     * current mapping only once the new one exists, so a failure  *
+     * leaves the object as it was                                 *
+     ***************************************************************/
+    void mapFile(size_t bytes)
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	void *address = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+			     fd, 0);
+	if (address == MAP_FAILED)
+	    throw("cannot map BigInteger file");
+	unmapFile();
+	base = (unsigned char *) address;
+	mappedBytes = bytes;
+	madvise(base, mappedBytes, MADV_SEQUENTIAL);
+#endif
+    }
+
+    void unmapFile()
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	if (base)
+	    munmap(base, mappedBytes);
+	base = 0;
+	mappedBytes = 0;
+#endif
+    }
+
+    /*************************************************************
+     * drop leading zero limbs and record sign and length in the *
+     * header, so that the file is always a valid checkpoint     *
+     *************************************************************/
+    void writeHeader()
+    {
+	while (numLimbs > 0 && limb(numLimbs - 1) == 0)
+	    --numLimbs;
+	if (numLimbs == 0)
+	    negative = false;	// zero is always positive
+
+	ULONG bits = 0;
+	if (numLimbs > 0) {
+	    CHUNK top = limb(numLimbs - 1);
+
+	    bits = (numLimbs - 1) * BigInteger::BitsPerChunk;
+	    for (; top; top >>= 1)
+		++bits;
+	}
+
+	base[0] = BigInteger::SerialFixed;
+	base[1] = negative ? 1 : 0;
+	storeLittleEndian(base + 8, bits);
+    }
+
+    /*************************************************
+     * compare magnitudes, ignoring sign: -1, 0 or 1 *
+     *************************************************/
+    static int compareMagnitude(const MappedBigInteger &a,
+				const MappedBigInteger &b)
+    {
+	ULONG index;
+
+	if (a.numLimbs != b.numLimbs)
+	    return a.numLimbs < b.numLimbs ? -1 : 1;
+	for (index = a.numLimbs; index > 0; --index) {
+	    CHUNK aDigit = a.limb(index - 1);
+	    CHUNK bDigit = b.limb(index - 1);
+	    if (aDigit != bDigit)
+		return aDigit < bDigit ? -1 : 1;
+	}
+	return 0;
+    }
+
+    /***********************************************
+     * zero limbs [from, to) of the file's storage *
+     ***********************************************/
+    void clearLimbs(ULONG from, ULONG to)
+    {
+	if (to > from)
+	    memset(limbAddress(from), 0, (to - from) * sizeof(CHUNK));
+    }
+
+    // not copyable; the mapping belongs to one object
+    MappedBigInteger(const MappedBigInteger &);
+    MappedBigInteger& operator= (const MappedBigInteger &);
+
+    public:
+    /***********************************************************
+     * create (or truncate) a file holding zero, with room for *
+     * 'capacityLimbs' limbs before the file has to grow       *
+     ***********************************************************/
+    MappedBigInteger(const std::string &path, ULONG capacityLimbs)
+	:fd(-1), base(0), mappedBytes(0), numLimbs(0), negative(false)
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	size_t bytes = BigInteger::SerialHeaderSize
+			   + (capacityLimbs ? capacityLimbs : 1) * sizeof(CHUNK);
+
+	fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	    throw("cannot create BigInteger file");
+	if (ftruncate(fd, bytes) != 0) {
+	    close(fd);
+	    throw("cannot size BigInteger file");
+	}
+	try {	// no destructor runs if the constructor throws
+	    mapFile(bytes);
+	} catch (...) {
+	    close(fd);
+	    throw;
+	}
+	writeHeader();
+#else
+	(void) path;
+	(void) capacityLimbs;
+	throw("memory mapped BigIntegers are not supported on this platform");
+#endif
+    }
+
+    /*******************************************************
+     * open an existing checkpoint for reading and writing *
+     *******************************************************/
+    explicit MappedBigInteger(const std::string &path)
+	:fd(-1), base(0), mappedBytes(0), numLimbs(0), negative(false)
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	struct stat status;
+
+	fd = open(path.c_str(), O_RDWR);
+	if (fd < 0)
+	    throw("cannot open BigInteger file");
+	if (fstat(fd, &status) != 0
+		|| (size_t) status.st_size < BigInteger::SerialHeaderSize) {
+	    close(fd);
+	    throw("truncated BigInteger data");
+	}
+
+	try {	// the view validates the header against the file size
+	    mapFile(status.st_size);
+	    BigIntegerView view(base, mappedBytes);
+	    numLimbs = view.limbCount();
+	    negative = view.isNegative();
+	    reserve(1);	// serialize() writes zero as a bare header
+	} catch (...) {
+	    unmapFile();
+	    close(fd);
+	    throw;
+	}
+#else
+	(void) path;
+	throw("memory mapped BigIntegers are not supported on this platform");
+#endif
+    }
+
+    ~MappedBigInteger()
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	unmapFile();
+	if (fd >= 0)
+	    close(fd);
+#endif
+    }
+
+    /************************************************************
+     * grow the file so it can hold at least 'limbs' limbs; the *
+     * size at least doubles so repeated growth stays linear    *
+     ************************************************************/
+    void reserve(ULONG limbs)
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	if (limbs <= capacity())
+	    return;
+	if (limbs < 2 * capacity())
+	    limbs = 2 * capacity();
+
+	size_t bytes = BigInteger::SerialHeaderSize + limbs * sizeof(CHUNK);
+
+	// the old mapping stays valid, and in use, until both succeed
+	if (ftruncate(fd, bytes) != 0)
+	    throw("cannot size BigInteger file");
+	mapFile(bytes);		// new space reads as zero
+#else
+	(void) limbs;
+#endif
+    }
+
+    /*******************************************************
+     * write dirty pages back to the file, for checkpoints *
+     *******************************************************/
+    void flush()
+    {
+#if defined(BIGINT_HAVE_MMAP)
+	if (msync(base, mappedBytes, MS_SYNC) != 0)
+	    throw("cannot write BigInteger file");
+#endif
+    }
+
+    ULONG limbCount() const
+    {
+	return numLimbs;
+    }
+
+    CHUNK limb(ULONG i) const
+    {
+	return loadLittleEndian(limbAddress(i));
+    }
+
+    bool isNegative() const
+    {
+	return negative;
+    }
+
+    BigIntegerView view() const
+    {
+	return BigIntegerView(base, mappedBytes);
+    }
+
+    BigInteger toBigInteger() const
+    {
+	return view().toBigInteger();
+    }
+
+    void assign(const BigInteger &value)
+    {
+	ULONG size = value.isZero(value) ? 0 : value.magnitude.size();
+	ULONG i;
+
+	reserve(size);
+	clearLimbs(size, numLimbs);
+	for (i = 0; i < size; ++i)
+	    storeLittleEndian(limbAddress(i), value.magnitude[i]);
+	numLimbs = size;
+	negative = value.sign == BigInteger::Negative;
+	writeHeader();
+    }
+
+    /***************************************************************
+     * result = a + b (or a - b), streaming from low to high limbs *
+     * result may be the same object as a or b                     *
+     ***************************************************************/
+    static void add(const MappedBigInteger &a, const MappedBigInteger &b,
+		    MappedBigInteger &result, bool subtract = false)
+    {
+	bool bNegative = b.negative != subtract;
+	bool sameSign = a.negative == bNegative;
+	const MappedBigInteger *large = &a, *small = &b;
+	bool resultNegative = a.negative;
+	ULONG i;
+
+	if (sameSign ? a.numLimbs < b.numLimbs
+		     : compareMagnitude(a, b) < 0) {
+	    large = &b;
+	    small = &a;
+	    if (!sameSign)
+		resultNegative = bNegative;
+	}
+
+	ULONG largeSize = large->numLimbs;
+	ULONG smallSize = small->numLimbs;
+	ULONG oldSize = result.numLimbs;
+
+	result.reserve(largeSize + 1);	// remaps a or b too if aliased
+
+	CHUNK carry = 0;	// or borrow
+	for (i = 0; i < largeSize; ++i) {
+	    CHUNK x = large->limb(i);
+	    CHUNK y = i < smallSize ? small->limb(i) : 0;
+	    CHUNK digit;
+	    CHUNK outCarry;
+
+	    if (sameSign) {
+		digit = x + y;
+		outCarry = digit < x;
+		digit += carry;
+		outCarry |= digit < carry;
+	    } else {
+		digit = x - y;
+		outCarry = x < y;
+		outCarry |= digit < carry;
+		digit -= carry;
+	    }
+	    storeLittleEndian(result.limbAddress(i), digit);
+	    carry = outCarry;
+	}
+	storeLittleEndian(result.limbAddress(largeSize), sameSign ? carry : 0);
+
+	result.clearLimbs(largeSize + 1, oldSize);
+	result.numLimbs = largeSize + 1;
+	result.negative = resultNegative;
+	result.writeHeader();
+    }
+
+    /**************************************************
+     * shift the magnitude in place; the sign is kept *
+     **************************************************/
+    void shiftLeft(ULONG bits)
+    {
+	ULONG limbShift = bits / BigInteger::BitsPerChunk;
+	unsigned bitShift = bits % BigInteger::BitsPerChunk;
+	ULONG oldSize = numLimbs;
+	ULONG index;
+
+	if (numLimbs == 0)
+	    return;
+	reserve(numLimbs + limbShift + 1);
+
+	// high to low, so no limb is overwritten before it is read
+	for (index = oldSize + 1; index > 0; --index) {
+	    ULONG i = index - 1;
+	    CHUNK current = i < oldSize ? limb(i) : 0;
+	    CHUNK low = 0;
+
+	    if (i > 0 && bitShift)
+		low = limb(i - 1) >> (BigInteger::BitsPerChunk - bitShift);
+	    storeLittleEndian(limbAddress(i + limbShift),
+			      (bitShift ? current << bitShift : current) | low);
+	}
+	clearLimbs(0, limbShift);
+
+	numLimbs = oldSize + limbShift + 1;
+	writeHeader();
+    }
+
+    void shiftRight(ULONG bits)
+    {
+	ULONG limbShift = bits / BigInteger::BitsPerChunk;
+	unsigned bitShift = bits % BigInteger::BitsPerChunk;
+	ULONG oldSize = numLimbs;
+	ULONG i;
+
+	if (limbShift >= numLimbs) {
+	    clearLimbs(0, numLimbs);
+	    numLimbs = 0;
+	    writeHeader();
+	    return;
+	}
+
+	// low to high, so no limb is overwritten before it is read
+	for (i = 0; i + limbShift < oldSize; ++i) {
+	    CHUNK current = limb(i + limbShift);
+	    CHUNK high = 0;
+
+	    if (bitShift && i + limbShift + 1 < oldSize)
+		high = limb(i + limbShift + 1)
+			   << (BigInteger::BitsPerChunk - bitShift);
+	    storeLittleEndian(limbAddress(i),
+			      (bitShift ? current >> bitShift : current) | high);
+	}
+	clearLimbs(oldSize - limbShift, oldSize);
+
+	numLimbs = oldSize - limbShift;
+	writeHeader();
+    }
+
+    /******************************************************************
+     * result = a * b in tiles of MultiplyBlockLimbs by               *
+     * MultiplyBlockLimbs limbs.  Each tile's product is formed on    *
+     * the heap by multiplyMagnitudes (Karatsuba at this size) and    *
+     * added into the file in one sequential pass, so only a block of *
+     * each operand and one tile are resident at any time.  The tiles *
+     * are still combined schoolbook fashion: an n limb product costs *
+     * (n / MultiplyBlockLimbs)^2 tile products, which is practical   *
+     * for operands of some gigabytes but not for much larger ones.   *
+     * result must not be the same object as a or b                   *
+     ******************************************************************/
+    static void multiply(const MappedBigInteger &a, const MappedBigInteger &b,
+			 MappedBigInteger &result)
+    {
+	ULONG aSize = a.numLimbs;
+	ULONG bSize = b.numLimbs;
+	std::vector<CHUNK> aBlock, bBlock, tile;
+	ULONG aStart, bStart, i, j;
+
+	if (&result == &a || &result == &b)
+	    throw("mapped multiply result must be a separate object");
+
+	result.reserve(aSize + bSize);
+	result.clearLimbs(0, result.capacity());
+	result.numLimbs = aSize + bSize;
+
+	for (aStart = 0; aStart < aSize; aStart += MultiplyBlockLimbs) {
+	    ULONG aCount = aSize - aStart < MultiplyBlockLimbs
+			   ? aSize - aStart : MultiplyBlockLimbs;
+	    aBlock.resize(aCount);
+	    for (i = 0; i < aCount; ++i)
+		aBlock[i] = a.limb(aStart + i);
+
+	    for (bStart = 0; bStart < bSize; bStart += MultiplyBlockLimbs) {
+		ULONG bCount = bSize - bStart < MultiplyBlockLimbs
+			       ? bSize - bStart : MultiplyBlockLimbs;
+		bBlock.resize(bCount);
+		for (j = 0; j < bCount; ++j)
+		    bBlock[j] = b.limb(bStart + j);
+
+		BigInteger::multiplyMagnitudes(aBlock, bBlock, tile);
+
+		// add the tile into the result, rippling any final carry
+		ULONG position = aStart + bStart;
+		CHUNK carry = 0;
+		for (i = 0; i < tile.size() || carry; ++i, ++position) {
+		    CHUNK digit = result.limb(position);
+		    CHUNK addend = i < tile.size() ? tile[i] : 0;
+
+		    digit += addend;
+		    CHUNK outCarry = digit < addend;
+		    digit += carry;
+		    carry = outCarry | (digit < carry);
+		    storeLittleEndian(result.limbAddress(position), digit);
+		}
+	    }
+	}
+
+	result.negative = a.negative != b.negative;
+	result.writeHeader();
+    }
+};
+
+/*******************************************************************
+ * Montgomery arithmetic                                           *
+ * A MontgomeryContext holds everything derived from one odd       *
+ * modulus n of N limbs: n' = -n^-1 mod 2^64, R mod n and R^2 mod  *
+ * n, where R = 2^(64 N).  A FieldElement bound to a context holds *
+ * a * R mod n, so each product costs one interleaved multiply and *
+ * reduce (CIOS) and never goes through binaryDivide.              *
+ * see: Koc, Acar and Kaliski, "Analyzing and Comparing Montgomery *
+ * Multiplication Algorithms", IEEE Micro 16(3), 1996              *
+ *******************************************************************/
+class FieldElement;
+
+class MontgomeryContext
+{
+    friend class FieldElement;
+    friend class BatchWorker;
+
+    private:
+    BigInteger modulusValue;
+    std::vector<CHUNK> n;	// the modulus, exactly N limbs
+    std::vector<CHUNK> rModN;	// 1 in Montgomery form
+    std::vector<CHUNK> r2ModN;	// converts into Montgomery form
+    CHUNK nPrime;		// -n^-1 mod 2^64
+    ULONG limbCount;		// N
+
+    // scratch on the stack for moduli up to this size
+    static const ULONG StackLimbs = 16;
+
+    /****************************************************************
+     * out = a * b / R mod n, for a, b < n; out may alias a or b.   *
+     * scratch, if given, has room for N + 2 limbs and spares the   *
+     * heap allocation that moduli of more than StackLimbs need     *
+     ****************************************************************/
+    void multiply(const CHUNK *a, const CHUNK *b, CHUNK *out,
+		  CHUNK *scratch = 0) const
+    {
+	CHUNK stackScratch[StackLimbs + 2];
+	std::vector<CHUNK> heapScratch;
+	CHUNK *t = scratch ? scratch : stackScratch;
+	ULONG i, j;
+
+	if (!scratch && limbCount > StackLimbs) {
+	    heapScratch.resize(limbCount + 2);
+	    t = &heapScratch[0];
+	}
+	for (i = 0; i < limbCount + 2; ++i)
+	    t[i] = 0;
+
+	for (i = 0; i < limbCount; ++i) {
+	    CHUNK carry = 0;
+	    CHUNK high, low;
+
+	    // t += a * b[i]
+	    for (j = 0; j < limbCount; ++j) {
+		low = mulChunks(a[j], b[i], high);
+		low += carry;
+		high += low < carry;
+		t[j] += low;
+		carry = high + (t[j] < low);
+	    }
+	    t[limbCount] += carry;
+	    t[limbCount + 1] = t[limbCount] < carry;
+
+	    // t = (t + m * n) / 2^64, with m chosen to clear t[0]
+	    CHUNK m = t[0] * nPrime;
+	    low = mulChunks(m, n[0], high);
+	    carry = high + (t[0] + low < low);
+	    for (j = 1; j < limbCount; ++j) {
+		low = mulChunks(m, n[j], high);
+		low += carry;
+		high += low < carry;
+		t[j - 1] = t[j] + low;
+		carry = high + (t[j - 1] < low);
+	    }
+	    t[limbCount - 1] = t[limbCount] + carry;
+	    t[limbCount] = t[limbCount + 1] + (t[limbCount - 1] < carry);
+	}
+
+	// t < 2n, so at most one subtraction is needed
+	if (t[limbCount] || compareLimbs(t, &n[0], limbCount) >= 0)
+	    subtractLimbs(t, &n[0], limbCount);
+	for (i = 0; i < limbCount; ++i)
+	    out[i] = t[i];
+    }
+
+    static int compareLimbs(const CHUNK *a, const CHUNK *b, ULONG count)
+    {
+	ULONG i;
+
+	for (i = count; i > 0; --i)
+	    if (a[i - 1] != b[i - 1])
+		return a[i - 1] < b[i - 1] ? -1 : 1;
+	return 0;
+    }
+
+    // a -= b over count limbs, returning the borrow out
+    static CHUNK subtractLimbs(CHUNK *a, const CHUNK *b, ULONG count)
+    {
+	CHUNK borrow = 0;
+	ULONG i;
+
+	for (i = 0; i < count; ++i) {
+	    CHUNK digit = a[i] - b[i];
+	    CHUNK outBorrow = a[i] < b[i];
+
+	    outBorrow |= digit < borrow;
+	    a[i] = digit - borrow;
+	    borrow = outBorrow;
+	}
+	return borrow;
+    }
+
+    // a += b over count limbs, returning the carry out
+    static CHUNK addLimbs(CHUNK *a, const CHUNK *b, ULONG count)
+    {
+	CHUNK carry = 0;
+	ULONG i;
+
+	for (i = 0; i < count; ++i) {
+	    CHUNK digit = a[i] + b[i];
+	    CHUNK outCarry = digit < b[i];
+
+	    digit += carry;
+	    outCarry |= digit < carry;
+	    a[i] = digit;
+	    carry = outCarry;
+	}
+	return carry;
+    }
+
+    /****************************************************************
+     * digits mod n, as exactly N limbs; digits need not be trimmed *
+     ****************************************************************/
+    std::vector<CHUNK> reduce(const std::vector<CHUNK> &digits) const
+    {
+	std::vector<CHUNK> quotient, remainder;
+	std::vector<CHUNK> trimmed(digits);
+
+	BigInteger::trimMagnitude(trimmed);
+	BigInteger::divideMagnitudes(trimmed, this->modulusValue.magnitude,
+				     quotient, remainder);
+	remainder.resize(limbCount, 0);
+	return remainder;
+    }
+
+    /*****************************************************************
+     * result = base^exponent mod n for base below n, by left-to-    *
+     * right square and multiply in Montgomery form; work holds the  *
+     * operands and the product scratch (3 N + 2 limbs), so a caller *
+     * that keeps it allocates nothing from one call to the next     *
+     *****************************************************************/
+    void pow(const std::vector<CHUNK> &base, const BigInteger &exponent,
+	     std::vector<CHUNK> &result, std::vector<CHUNK> &work) const
+    {
+	ULONG i = exponent.bitLength();
+	ULONG k;
+
+	work.assign(3 * limbCount + 2, 0);
+	CHUNK *power = &work[0];
+	CHUNK *answer = &work[limbCount];
+	CHUNK *scratch = &work[2 * limbCount];
+
+	for (k = 0; k < base.size(); ++k)
+	    answer[k] = base[k];
+	multiply(answer, &r2ModN[0], power, scratch);	// base * R mod n
+	for (k = 0; k < limbCount; ++k)
+	    answer[k] = rModN[k];
+	for (; i > 0; --i) {
+	    ULONG bit = i - 1;
+
+	    multiply(answer, answer, answer, scratch);
+	    if (exponent.magnitude[bit / BigInteger::BitsPerChunk]
+		    & (BigInteger::LOW_BIT << (bit % BigInteger::BitsPerChunk)))
+		multiply(answer, power, answer, scratch);
+	}
+
+	for (k = 0; k < limbCount; ++k)		// out of Montgomery form
+	    power[k] = k == 0;
+	multiply(answer, power, answer, scratch);
+	result.assign(answer, answer + limbCount);
+	BigInteger::trimMagnitude(result);
+    }
+
+    public:
+    /****************************************************************
+     * the modulus must be odd and greater than one; FieldElement's *
+     * inverse() additionally assumes that it is prime              *
+     ****************************************************************/
+    explicit MontgomeryContext(const BigInteger &modulus)
+	:modulusValue(modulus)
+    {
+	if (modulus.sign == BigInteger::Negative
+		|| !(modulus.magnitude[0] & 1)
+		|| (modulus.magnitude.size() == 1 && modulus.magnitude[0] == 1))
+	    throw("Montgomery modulus must be odd and greater than one");
+
+	n = modulus.magnitude;
+	limbCount = n.size();
+
+	nPrime = 0 - BigInteger::inverseChunk(n[0]);
+
+	std::vector<CHUNK> power(2 * limbCount + 1, 0);
+	power[limbCount] = 1;
+	rModN = reduce(power);
+	power[limbCount] = 0;
+	power[2 * limbCount] = 1;
+	r2ModN = reduce(power);
+    }
+
+    const BigInteger &modulus() const
+    {
+	return this->modulusValue;
+    }
+
+    ULONG limbs() const
+    {
+	return limbCount;
+    }
+};
+
+/*****************************************************************
+ * an element of Z/nZ, kept in Montgomery form                   *
+ * Additions and subtractions are lazy: the limbs may hold any   *
+ * value below bound * n (one spare limb leaves room for that),  *
+ * and are only reduced when a product, comparison or conversion *
+ * needs a value below n, or the bound would grow past           *
+ * MaxLazyBound.  The context must outlive its elements.         *
+ *****************************************************************/
+class FieldElement
+{
+    private:
+    const MontgomeryContext *context;
+    std::vector<CHUNK> limbs;	// N + 1 limbs, value < bound * n
+    ULONG bound;
+
+    static const ULONG MaxLazyBound = 1ULL << 32;
+
+    FieldElement(const MontgomeryContext *contextArg,
+		 const std::vector<CHUNK> &montgomeryLimbs)
+	:context(contextArg), limbs(montgomeryLimbs), bound(1)
+    {
+	this->limbs.resize(contextArg->limbCount + 1, 0);
+    }
+
+    void checkContext(const FieldElement &other) const
+    {
+	if (this->context != other.context)
+	    throw("field elements belong to different contexts");
+    }
+
+    /***********************************************************
+     * bring the value below n: a few subtractions for a small *
+     * bound, a division for a large one                       *
+     ***********************************************************/
+    void reduce()
+    {
+	ULONG count = context->limbCount;
+
+	if (bound <= 1)
+	    return;
+	if (bound <= 8) {
+	    while (limbs[count] || MontgomeryContext::compareLimbs(
+			&limbs[0], &context->n[0], count) >= 0)
+		limbs[count] -= MontgomeryContext::subtractLimbs(
+				    &limbs[0], &context->n[0], count);
+	} else {
+	    limbs = context->reduce(limbs);
+	    limbs.push_back(0);
+	}
+	bound = 1;
+    }
+
+    // this += multiple * n, where multiple * n fits the spare limb
+    void addMultipleOfModulus(ULONG multiple)
+    {
+	ULONG count = context->limbCount;
+	CHUNK carry = 0;
+	ULONG i;
+
+	for (i = 0; i < count; ++i) {
+	    CHUNK high;
+	    CHUNK low = mulChunks(context->n[i], multiple, high);
+
+	    low += carry;
+	    high += low < carry;
+	    limbs[i] += low;
+	    carry = high + (limbs[i] < low);
+	}
+	limbs[count] += carry;
+    }
+
+    public:
+    FieldElement(const MontgomeryContext &contextArg,
+		 const BigInteger &value = BigInteger(0))
+	:context(&contextArg), bound(1)
+    {
+	std::vector<CHUNK> residue = contextArg.reduce(value.magnitude);
+
+	if (value.sign == BigInteger::Negative) {	// n - residue
+	    std::vector<CHUNK> negated(contextArg.n);
+
+	    MontgomeryContext::subtractLimbs(&negated[0], &residue[0],
+					     contextArg.limbCount);
+	    if (negated != contextArg.n)
+		residue = negated;
+	}
+	limbs.resize(contextArg.limbCount + 1, 0);
+	contextArg.multiply(&residue[0], &contextArg.r2ModN[0], &limbs[0]);
+    }
+
+    static FieldElement one(const MontgomeryContext &contextArg)
+    {
+	return FieldElement(&contextArg, contextArg.rModN);
+    }
+
+    const MontgomeryContext &field() const
+    {
+	return *this->context;
+    }
+
+    // the ordinary value, in [0, n)
+    BigInteger toBigInteger() const
+    {
+	FieldElement reduced(*this);
+	std::vector<CHUNK> unit(context->limbCount, 0);
+	BigInteger answer;
+
+	reduced.reduce();
+	unit[0] = 1;
+	context->multiply(&reduced.limbs[0], &unit[0], &reduced.limbs[0]);
+	answer.magnitude.assign(reduced.limbs.begin(),
+				reduced.limbs.begin() + context->limbCount);
+	BigInteger::trimMagnitude(answer.magnitude);
+	return answer;
+    }
+
+    bool isZero() const
+    {
+	FieldElement reduced(*this);
+	ULONG i;
+
+	reduced.reduce();
+	for (i = 0; i < context->limbCount; ++i)
+	    if (reduced.limbs[i])
+		return false;
+	return true;
+    }
+
+    /*************
+     * Operators *
+     *************/
+    FieldElement& operator+= (const FieldElement &other)
+    {
+	checkContext(other);
+	if (bound + other.bound > MaxLazyBound) {
+	    FieldElement reducedOther(other);
+
+	    reduce();
+	    reducedOther.reduce();
+	    return *this += reducedOther;
+	}
+	MontgomeryContext::addLimbs(&limbs[0], &other.limbs[0], limbs.size());
+	bound += other.bound;
+	return *this;
+    }
+
+    // adds other.bound * n first, so the difference stays positive
+    FieldElement& operator-= (const FieldElement &other)
+    {
+	checkContext(other);
+	if (bound + other.bound > MaxLazyBound) {
+	    FieldElement reducedOther(other);
+
+	    reduce();
+	    reducedOther.reduce();
+	    return *this -= reducedOther;
+	}
+	addMultipleOfModulus(other.bound);
+	MontgomeryContext::subtractLimbs(&limbs[0], &other.limbs[0],
+					 limbs.size());
+	bound += other.bound;
+	return *this;
+    }
+
+    FieldElement& operator*= (const FieldElement &other)
+    {
+	FieldElement reducedOther(other);
+
+	checkContext(other);
+	reduce();
+	reducedOther.reduce();
+	context->multiply(&limbs[0], &reducedOther.limbs[0], &limbs[0]);
+	return *this;
+    }
+
+    FieldElement operator+ (const FieldElement &other) const
+    {
+	FieldElement answer(*this);
+
+	answer += other;
+	return answer;
+    }
+
+    FieldElement operator- (const FieldElement &other) const
+    {
+	FieldElement answer(*this);
+
+	answer -= other;
+	return answer;
+    }
+
+    FieldElement operator* (const FieldElement &other) const
+    {
+	FieldElement answer(*this);
+
+	answer *= other;
+	return answer;
+    }
+
+    // Unary minus operator
+    FieldElement operator- () const
+    {
+	FieldElement answer(context, std::vector<CHUNK>());
+
+	answer -= *this;
+	return answer;
+    }
+
+    bool operator== (const FieldElement &other) const
+    {
+	FieldElement left(*this);
+	FieldElement right(other);
+
+	checkContext(other);
+	left.reduce();
+	right.reduce();
+	return left.limbs == right.limbs;
+    }
+
+    bool operator!= (const FieldElement &other) const
+    {
+	return !(*this == other);
+    }
+
+    FieldElement square() const
+    {
+	return *this * *this;
+    }
+
+    // left-to-right square and multiply, all in Montgomery form
+    FieldElement pow(const BigInteger &exponent) const
+    {
+	FieldElement base(*this);
+	FieldElement result(one(*context));
+	ULONG i = exponent.magnitude.size() * BigInteger::BitsPerChunk;
+
+	if (exponent.sign == BigInteger::Negative)
+	    throw("negative exponent");
+	base.reduce();
+	for (; i > 0; --i) {
+	    ULONG bit = i - 1;
+
+	    context->multiply(&result.limbs[0], &result.limbs[0],
+			      &result.limbs[0]);
+	    if (exponent.magnitude[bit / BigInteger::BitsPerChunk]
+		    & (BigInteger::LOW_BIT << (bit % BigInteger::BitsPerChunk)))
+		context->multiply(&result.limbs[0], &base.limbs[0],
+				  &result.limbs[0]);
+	}
+	return result;
+    }
+
+    /***************************************************
+     * multiplicative inverse by Fermat: a^(n-2) mod n *
+     * (the modulus must be prime)                     *
+     ***************************************************/
+    FieldElement inverse() const
+    {
+	if (isZero())
+	    throw("zero has no inverse");
+	return pow(context->modulusValue - BigInteger(2));
+    }
+
+    /**************************************************************
+     * invert every element with one inverse() and 3 (k - 1)      *
+     * products (Montgomery's trick): prefix products, invert the *
+     * total, then peel the elements off from the end             *
+     **************************************************************/
+    static void batchInvert(std::vector<FieldElement> &elements)
+    {
+	size_t i;
+
+	if (elements.empty())
+	    return;
+
+	std::vector<FieldElement> prefix;
+	prefix.reserve(elements.size());
+	prefix.push_back(elements[0]);
+	for (i = 1; i < elements.size(); ++i)
+	    prefix.push_back(prefix[i - 1] * elements[i]);
+
+	FieldElement running = prefix.back().inverse();
+	for (i = elements.size() - 1; i > 0; --i) {
+	    FieldElement inverse = running * prefix[i - 1];
+
+	    running *= elements[i];
+	    elements[i] = inverse;
+	}
+	elements[0] = running;
+    }
+};
+
+inline std::ostream& operator<< (std::ostream &strm, const FieldElement &value)
+{
+    value.toBigInteger().writeTo(strm);
+    return strm;
+}
+
+/****************************************************************
+ * Batch operations                                             *
+ * apply the same operation to many independent values, with    *
+ * the work partitioned across the available cores              *
+ ****************************************************************/
+
+// elements handed to a worker at a time
+static const size_t BatchGrainSize = 64;
+
+/*******************************************************************
+ * a fixed set of worker threads, started on first use and kept    *
+ * until the program exits, so a batch call costs a wake-up rather *
+ * than a thread start per core.  run() hands out [0, count) in    *
+ * chunks of 'grain' elements from a shared counter, with the      *
+ * calling thread taking chunks too, so a worker that draws cheap  *
+ * elements simply comes back for more.  Jobs from concurrent      *
+ * callers are open together and the workers take turns between    *
+ * them, so every caller keeps a share of the cores; only a call   *
+ * made from inside a job runs on its own thread alone             *
+ *******************************************************************/
+class WorkerPool
+{
+    private:
+    // one run() call; lives on its caller's stack
+    struct Job {
+	const std::function<void(size_t, size_t)> *work;
+	size_t count, grain;
+	std::atomic<size_t> next;	// first element not yet claimed
+	size_t workers;			// pool threads inside it, under lock
+	std::exception_ptr error;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex lock;			// guards everything below
+    std::condition_variable wake;	// a new job, or stopping
+    std::condition_variable finished;	// a job's last worker left it
+    std::list<Job *> jobs;		// open jobs, taken in turn
+    bool stopping;
+
+    static bool &insideJob()
+    {
+	static thread_local bool inside = false;
+
+	return inside;
+    }
+
+    WorkerPool(const WorkerPool &);
+    WorkerPool &operator= (const WorkerPool &);
+
+    WorkerPool()
+	:stopping(false)
+    {
+	unsigned cores = std::thread::hardware_concurrency();
+	unsigned t;
+
+	for (t = 1; t < cores; ++t)	// the caller is a worker too
+	    threads.push_back(std::thread([this]() { workerLoop(); }));
+    }
+
+    // run the chunk of job starting at begin
+    void runChunk(Job &job, size_t begin)
+    {
+	size_t end = job.count - begin > job.grain
+		     ? begin + job.grain : job.count;
+
+	insideJob() = true;
+	try {
+	    (*job.work)(begin, end);
+	} catch (...) {		// e.g. divide by zero; hand it to the caller
+	    std::lock_guard<std::mutex> guard(lock);
+	    if (!job.error)
+		job.error = std::current_exception();
+	    job.next.store(job.count);	// and stop handing out work
+	}
+	insideJob() = false;
+    }
+
+    /****************************************************************
+     * claim one chunk of the job at the front and move the job to  *
+     * the back, so that the workers go round all open jobs chunk   *
+     * by chunk; a job with nothing left to claim is dropped        *
+     ****************************************************************/
+    void workerLoop()
+    {
+	std::unique_lock<std::mutex> guard(lock);
+
+	for (;;) {
+	    wake.wait(guard, [&]() { return stopping || !jobs.empty(); });
+	    if (stopping)
+		return;
+
+	    Job &job = *jobs.front();
+	    size_t begin = job.next.fetch_add(job.grain);
+
+	    if (begin >= job.count) {
+		jobs.pop_front();
+		continue;
+	    }
+	    jobs.splice(jobs.end(), jobs, jobs.begin());
+	    ++job.workers;
+	    guard.unlock();
+	    runChunk(job, begin);
+	    guard.lock();
+	    if (--job.workers == 0)
+		finished.notify_all();
+	}
+    }
+
+    public:
+    static WorkerPool &instance()
+    {
+	static WorkerPool pool;
+
+	return pool;
+    }
+
+    ~WorkerPool()
+    {
+	size_t t;
+
+	{
+	    std::lock_guard<std::mutex> guard(lock);
+	    stopping = true;
+	}
+	wake.notify_all();
+	for (t = 0; t < threads.size(); ++t)
+	    threads[t].join();
+    }
+
+    // threads that take part in a job, the caller included
+    size_t size() const
+    {
+	return threads.size() + 1;
+    }
+
+    void run(size_t countArg, size_t grainArg,
+	     const std::function<void(size_t, size_t)> &work)
+    {
+	size_t begin;
+
+	if (insideJob() || threads.empty()) {
+	    for (begin = 0; begin < countArg; begin += grainArg)
+		work(begin, countArg - begin > grainArg
+			    ? begin + grainArg : countArg);
+	    return;
+	}
+
+	Job job;
+	job.work = &work;
+	job.count = countArg;
+	job.grain = grainArg;
+	job.next.store(0);
+	job.workers = 0;
+	{
+	    std::lock_guard<std::mutex> guard(lock);
+	    jobs.push_back(&job);
+	}
+	wake.notify_all();
+	while ((begin = job.next.fetch_add(grainArg)) < countArg)
+	    runChunk(job, begin);
+
+	// nothing is left to claim; wait for the chunks still running
+	std::unique_lock<std::mutex> guard(lock);
+	jobs.remove(&job);
+	finished.wait(guard, [&]() { return job.workers == 0; });
+	guard.unlock();
+	if (job.error)
+	    std::rethrow_exception(job.error);
+    }
+};
+
+/***************************************************************
+ * run work(begin, end) over [0, count) on the worker pool, in *
+ * chunks of at most grain elements; short ranges run serially *
+ ***************************************************************/
+template <class Work>
+void parallelFor(size_t count, size_t grain, Work work)
+{
+    if (grain == 0)
+	grain = 1;
+    if (count <= grain) {
+	if (count)
+	    work(0, count);
+	return;
+    }
+    WorkerPool::instance().run(count, grain, work);
+}
+
+/*****************************************************************
+ * per-thread scratch for the batch kernels.  The pool's threads *
+ * live as long as the program, so these buffers keep their      *
+ * capacity from one element, and one batch call, to the next    *
+ *****************************************************************/
+class BatchWorker
+{
+    private:
+    std::vector<CHUNK> product, quotient, remainder, power;
+
+    // result takes a copy of digits, reusing its own storage
+    static void store(const std::vector<CHUNK> &digits, bool negative,
+		      BigInteger &result)
+    {
+	result.magnitude.assign(digits.begin(), digits.end());
+	result.sign = negative && (digits.size() > 1 || digits[0])
+		      ? BigInteger::Negative : BigInteger::Positive;
+    }
+
+    void reduce(const std::vector<CHUNK> &value, const BigInteger &modulus,
+		BigInteger &result)
+    {
+	if (modulus.magnitude.size() == 1 && modulus.magnitude[0] == 0)
+	    throw("divide by zero");
+	BigInteger::divideMagnitudes(value, modulus.magnitude, quotient,
+				     remainder);
+	store(remainder, false, result);
+    }
+
+    public:
+    static BatchWorker &local()
+    {
+	static thread_local BatchWorker worker;
+
+	return worker;
+    }
+
+    void multiply(const BigInteger &a, const BigInteger &b,
+		  BigInteger &result)
+    {
+	BigInteger::multiplyMagnitudes(a.magnitude, b.magnitude, product);
+	store(product, a.sign != b.sign, result);
+    }
+
+    // the remainder as '%' gives it: |a| mod |b|
+    void mod(const BigInteger &a, const BigInteger &b, BigInteger &result)
+    {
+	reduce(a.magnitude, b, result);
+    }
+
+    void modMultiply(const BigInteger &a, const BigInteger &b,
+		     const BigInteger &modulus, BigInteger &result)
+    {
+	BigInteger::multiplyMagnitudes(a.magnitude, b.magnitude, product);
+	reduce(product, modulus, result);
+    }
+
+    /****************************************************************
+     * result = base^exponent mod modulus, in [0, modulus); context *
+     * is the modulus's MontgomeryContext when it is odd and above  *
+     * one, and 0 otherwise, when each square and product is        *
+     * reduced by a long division instead                           *
+     ****************************************************************/
+    void modPow(const BigInteger &base, const BigInteger &exponent,
+		const BigInteger &modulus, const MontgomeryContext *context,
+		BigInteger &result)
+    {
+	ULONG i = exponent.bitLength();
+
+	if (exponent.sign == BigInteger::Negative)
+	    throw("negative exponent");
+	BigInteger::divideMagnitudes(base.magnitude, modulus.magnitude,
+				     quotient, power);
+	if (base.sign == BigInteger::Negative
+		&& (power.size() > 1 || power[0])) {	// modulus - power
+	    remainder = modulus.magnitude;
+	    BigInteger::subtractMagnitudeFrom(remainder, power);
+	    power.swap(remainder);
+	}
+
+	if (context) {
+	    context->pow(power, exponent, remainder, product);
+	    store(remainder, false, result);
+	    return;
+	}
+
+	// left-to-right square and multiply; 1 mod 1 is 0
+	remainder.assign(1, modulus.magnitude.size() > 1
+			    || modulus.magnitude[0] != 1);
+	for (; i > 0; --i) {
+	    ULONG bit = i - 1;
+	    CHUNK limb = exponent.magnitude[bit / BigInteger::BitsPerChunk];
+
+	    BigInteger::squareMagnitude(remainder, product);
+	    BigInteger::divideMagnitudes(product, modulus.magnitude, quotient,
+					 remainder);
+	    if ((limb >> (bit % BigInteger::BitsPerChunk)) & 1) {
+		BigInteger::multiplyMagnitudes(remainder, power, product);
+		BigInteger::divideMagnitudes(product, modulus.magnitude,
+					     quotient, remainder);
+	    }
+	}
+	store(remainder, false, result);
+    }
+
+    // the context modPow wants for modulus, or 0 for an even modulus
+    static MontgomeryContext *contextFor(const BigInteger &modulus)
+    {
+	if (modulus.sign == BigInteger::Negative
+		|| (modulus.magnitude.size() == 1 && modulus.magnitude[0] == 0))
+	    throw("modulus must be positive");
+	if (!(modulus.magnitude[0] & 1)
+		|| (modulus.magnitude.size() == 1 && modulus.magnitude[0] == 1))
+	    return 0;
+	return new MontgomeryContext(modulus);
+    }
+};
+
+inline BigInteger BigInteger::modPow(const BigInteger &exponent,
+				     const BigInteger &modulus) const
+{
+    std::unique_ptr<MontgomeryContext> context(
+	BatchWorker::contextFor(modulus));
+    BigInteger result;
+
+    BatchWorker::local().modPow(*this, exponent, modulus, context.get(),
+				result);
+    return result;
+}
+
+/*******************************************************
+ * all element-wise batch operations take equal length *
+ * inputs and size the result to match                 *
+ *******************************************************/
+inline void checkBatchSizes(const std::vector<BigInteger> &a,
+			    const std::vector<BigInteger> &b,
+			    std::vector<BigInteger> &result)
+{
+    if (a.size() != b.size())
+	throw("batch size mismatch");
+    result.resize(a.size());
+}
+
+// result[i] = a[i] + b[i]
+inline void batchAdd(const std::vector<BigInteger> &a,
+		     const std::vector<BigInteger> &b,
+		     std::vector<BigInteger> &result)
+{
+    checkBatchSizes(a, b, result);
+    parallelFor(a.size(), BatchGrainSize, [&](size_t begin, size_t end)
+    {
+	for (size_t i = begin; i < end; ++i) {
+	    result[i] = a[i];
+	    result[i] += b[i];
+	}
+    });
+}
+
+// result[i] = a[i] - b[i]
+inline void batchSubtract(const std::vector<BigInteger> &a,
+			  const std::vector<BigInteger> &b,
+			  std::vector<BigInteger> &result)
+{
+    checkBatchSizes(a, b, result);
+    parallelFor(a.size(), BatchGrainSize, [&](size_t begin, size_t end)
+    {
+	for (size_t i = begin; i < end; ++i) {
+	    result[i] = a[i];
+	    result[i] -= b[i];
+	}
+    });
+}
+
+// result[i] = a[i] * b[i]
+inline void batchMultiply(const std::vector<BigInteger> &a,
+			  const std::vector<BigInteger> &b,
+			  std::vector<BigInteger> &result)
+{
+    checkBatchSizes(a, b, result);
+    parallelFor(a.size(), BatchGrainSize, [&](size_t begin, size_t end)
+    {
+	BatchWorker &worker = BatchWorker::local();
+
+	for (size_t i = begin; i < end; ++i)
+	    worker.multiply(a[i], b[i], result[i]);
+    });
+}
+
+// result[i] = a[i] % b[i]
+inline void batchMod(const std::vector<BigInteger> &a,
+		     const std::vector<BigInteger> &b,
+		     std::vector<BigInteger> &result)
+{
+    checkBatchSizes(a, b, result);
+    parallelFor(a.size(), BatchGrainSize, [&](size_t begin, size_t end)
+    {
+	BatchWorker &worker = BatchWorker::local();
+
+	for (size_t i = begin; i < end; ++i)
+	    worker.mod(a[i], b[i], result[i]);
+    });
+}
+
+// result[i] = a[i] * b[i] % modulus
+inline void batchModMultiply(const std::vector<BigInteger> &a,
+			     const std::vector<BigInteger> &b,
+			     const BigInteger &modulus,
+			     std::vector<BigInteger> &result)
+{
+    checkBatchSizes(a, b, result);
+    parallelFor(a.size(), BatchGrainSize, [&](size_t begin, size_t end)
+    {
+	BatchWorker &worker = BatchWorker::local();
+
+	for (size_t i = begin; i < end; ++i)
+	    worker.modMultiply(a[i], b[i], modulus, result[i]);
+    });
+}
+
+// result[i] = base[i] raised to exponent[i], modulo modulus
+inline void batchModPow(const std::vector<BigInteger> &base,
+			const std::vector<BigInteger> &exponent,
+			const BigInteger &modulus,
+			std::vector<BigInteger> &result)
+{
+    checkBatchSizes(base, exponent, result);
+    std::unique_ptr<MontgomeryContext> context(
+	BatchWorker::contextFor(modulus));
+
+    // each element is a long chain of products, and the chains differ
+    // in length with the exponents, so they are handed out one by one
+    parallelFor(base.size(), 1, [&](size_t begin, size_t end)
+    {
+	BatchWorker &worker = BatchWorker::local();
+
+	for (size_t i = begin; i < end; ++i)
+	    worker.modPow(base[i], exponent[i], modulus, context.get(),
+			  result[i]);
+    });
+}
+
+// result[i] = -1, 0 or 1 as a[i] is less than, equal to or greater than b[i]
+inline void batchCompare(const std::vector<BigInteger> &a,
+			 const std::vector<BigInteger> &b,
+			 std::vector<int> &result)
+{
+    if (a.size() != b.size())
+	throw("batch size mismatch");
+    result.resize(a.size());
+    parallelFor(a.size(), BatchGrainSize, [&](size_t begin, size_t end)
+    {
+	for (size_t i = begin; i < end; ++i)
+	    result[i] = a[i] < b[i] ? -1 : (a[i] > b[i] ? 1 : 0);
+    });
+}
+
+/*****************************************************************
+ * combine values[begin, end) pairwise in a balanced tree, so    *
+ * that operands of similar size meet at each level; this keeps  *
+ * a long product from degenerating into one huge times one tiny *
+ *****************************************************************/
+template <class Combine>
+BigInteger treeReduce(const std::vector<BigInteger> &values,
+		      size_t begin, size_t end, Combine combine)
+{
+    if (end - begin == 1)
+	return values[begin];
+
+    size_t middle = begin + (end - begin) / 2;
+    BigInteger left = treeReduce(values, begin, middle, combine);
+    BigInteger right = treeReduce(values, middle, end, combine);
+
+    combine(left, right);
+    return left;
+}
+
+/*****************************************************************
+ * reduce values with combine: each worker reduces its own range *
+ * as a tree, and the per-worker results are then combined as a  *
+ * tree in the same way                                          *
+ *****************************************************************/
+template <class Combine>
+BigInteger batchReduce(const std::vector<BigInteger> &values,
+		       const BigInteger &identity, Combine combine)
+{
+    size_t numParts = WorkerPool::instance().size();
+
+    if (values.empty())
+	return identity;
+    if (numParts > values.size() / BatchGrainSize)
+	numParts = values.size() / BatchGrainSize;
+    if (numParts <= 1)
+	return treeReduce(values, 0, values.size(), combine);
+
+    std::vector<BigInteger> partial(numParts);
+    size_t perPart = values.size() / numParts;
+
+    parallelFor(numParts, 1, [&](size_t begin, size_t end)
+    {
+	for (size_t p = begin; p < end; ++p) {
+	    size_t first = p * perPart;
+	    size_t last = (p == numParts - 1) ? values.size() : first + perPart;
+	    partial[p] = treeReduce(values, first, last, combine);
+	}
+    });
+
+    return treeReduce(partial, 0, partial.size(), combine);
+}
+
+// sum of all values; zero for an empty batch
+inline BigInteger batchSum(const std::vector<BigInteger> &values)
+{
+    return batchReduce(values, BigInteger(0),
+		       [](BigInteger &left, const BigInteger &right)
+		       { left += right; });
+}
+
+// product of all values; one for an empty batch.  The top levels of
+// the tree meet operands long enough for Karatsuba
+inline BigInteger batchProduct(const std::vector<BigInteger> &values)
+{
+    return batchReduce(values, BigInteger(1),
+		       [](BigInteger &left, const BigInteger &right)
+		       { BatchWorker::local().multiply(left, right, left); });
+}
+
+/***************************************************************
+ * fill every element of values with a random value, drawing   *
+ * from source in element order rather than across threads, so *
+ * a seeded source produces the same batch on every run        *
+ ***************************************************************/
+inline void batchRandom(std::vector<BigInteger> &values, ULONG bits,
+			RandomSource &source = defaultRandomSource())
+{
+    for (size_t i = 0; i < values.size(); ++i)
+	values[i] = BigInteger::random(bits, source);
+}
+
+inline void batchRandomBelow(std::vector<BigInteger> &values,
+			     const BigInteger &bound,
+			     RandomSource &source = defaultRandomSource())
+{
+    for (size_t i = 0; i < values.size(); ++i)
+	values[i] = BigInteger::randomBelow(bound, source);
+}
+
+/******************************************************************
+ * FixedInt<Bits, Signed>                                         *
+ * An integer of exactly Bits bits (a multiple of 64) whose limbs *
+ * are held inline, so it never touches the heap.  Arithmetic     *
+ * wraps around modulo 2^Bits like the built-in unsigned types; a *
+ * Signed FixedInt reads the same bits as two's complement.  With *
+ * C++14 every operation is constexpr, so constants fold at       *
+ * compile time:                                                  *
+ *     constexpr FixedInt<256> p = FixedInt<256>::parse("0x..."); *
+ * / and % behave as they do for BigInteger: the quotient is      *
+ * truncated toward zero and the remainder is |this| mod |other|. *
+ ******************************************************************/
+template <unsigned Bits, bool Signed>
+class FixedInt
+{
+    static_assert(Bits > 0 && Bits % 64 == 0,
+		  "FixedInt width must be a multiple of 64 bits");
+
+    template <unsigned, bool> friend class FixedInt;
+
+    public:
+    static const unsigned Limbs = Bits / 64;
+
+    private:
+    CHUNK limbs[Limbs];		// least significant first
+
+    static const unsigned BitsPerChunk = 64;
+
+    /***************************************************
+     * store a single CHUNK, sign extended if negative *
+     ***************************************************/
+    BIGINT_CONSTEXPR14 void setChunk(CHUNK value, bool negative)
+    {
+	unsigned i = 1;
+
+	limbs[0] = value;
+	for (; i < Limbs; ++i)
+	    limbs[i] = negative ? ~(CHUNK) 0 : 0;
+    }
+
+    /********************************************************
+     * this += other + carry, returning the carry out; with *
+     * invert set, other is complemented first, so that     *
+     * invert and a carry in of 1 subtract                  *
+     ********************************************************/
+    BIGINT_CONSTEXPR14 CHUNK addLimbs(const FixedInt &other, bool invert,
+				      CHUNK carry)
+    {
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i) {
+	    CHUNK addend = invert ? ~other.limbs[i] : other.limbs[i];
+	    CHUNK sum = limbs[i] + addend;
+	    CHUNK carryOut = sum < addend;
+
+	    sum += carry;
+	    carryOut |= sum < carry;
+	    limbs[i] = sum;
+	    carry = carryOut;
+	}
+	return carry;
+    }
+
+    /**************************************************
+     * product truncated to Limbs limbs; the same for *
+     * signed and unsigned values, since both wrap    *
+     **************************************************/
+    static BIGINT_CONSTEXPR14 FixedInt multiplyLimbs(const FixedInt &a,
+						     const FixedInt &b)
+    {
+	FixedInt product;
+	unsigned i = 0, j = 0;
+
+	for (i = 0; i < Limbs; ++i) {
+	    CHUNK carry = 0;
+
+	    if (a.limbs[i] == 0)
+		continue;
+	    for (j = 0; i + j < Limbs; ++j) {
+		CHUNK high = 0;
+		CHUNK low = mulChunks(a.limbs[i], b.limbs[j], high);
+
+		low += carry;
+		high += low < carry;
+		low += product.limbs[i + j];
+		high += low < product.limbs[i + j];
+		product.limbs[i + j] = low;
+		carry = high;
+	    }
+	}
+	return product;
+    }
+
+    // number of limbs up to and including the top non-zero one
+    BIGINT_CONSTEXPR14 unsigned usedLimbs() const
+    {
+	unsigned used = Limbs;
+
+	while (used > 1 && limbs[used - 1] == 0)
+	    --used;
+	return used;
+    }
+
+    /***********************************************************
+     * unsigned long division, as BigInteger::divideMagnitudes *
+     * but on fixed arrays (Knuth, TAOCP vol. 2, 4.3.1 (D))    *
+     * divisor must be non-zero                                *
+     ***********************************************************/
+    static BIGINT_CONSTEXPR14 void divideLimbs(const FixedInt &dividend,
+					       const FixedInt &divisor,
+					       FixedInt &quotient,
+					       FixedInt &remainder)
+    {
+	unsigned n = divisor.usedLimbs();
+	unsigned m = dividend.usedLimbs();
+	unsigned i = 0, index = 0, shift = 0;
+
+	quotient = FixedInt();
+	remainder = FixedInt();
+
+	if (compareUnsigned(dividend, divisor) < 0) {
+	    remainder = dividend;
+	    return;
+	}
+
+	if (n == 1) {
+	    CHUNK rem = 0;
+
+	    for (index = m; index > 0; --index)
+		quotient.limbs[index - 1] = divChunks(rem,
+						      dividend.limbs[index - 1],
+						      divisor.limbs[0], rem);
+	    remainder.limbs[0] = rem;
+	    return;
+	}
+
+	// normalize so that the divisor's top bit is set
+	while (!((divisor.limbs[n - 1] << shift) >> (BitsPerChunk - 1)))
+	    ++shift;
+
+	CHUNK v[Limbs] = {};
+	CHUNK u[Limbs + 1] = {};
+	for (i = n; i > 0; --i)
+	    v[i - 1] = (divisor.limbs[i - 1] << shift)
+		| (shift && i > 1
+		   ? divisor.limbs[i - 2] >> (BitsPerChunk - shift) : 0);
+	u[m] = shift ? dividend.limbs[m - 1] >> (BitsPerChunk - shift) : 0;
+	for (i = m; i > 0; --i)
+	    u[i - 1] = (dividend.limbs[i - 1] << shift)
+		| (shift && i > 1
+		   ? dividend.limbs[i - 2] >> (BitsPerChunk - shift) : 0);
+
+	for (index = m - n + 1; index > 0; --index) {
+	    unsigned j = index - 1;
+	    CHUNK qHat = 0, rHat = 0;
+	    bool rHatOverflow = false;
+
+	    // estimate from the top two limbs, then refine with the third
+	    if (u[j + n] >= v[n - 1]) {
+		qHat = ~(CHUNK) 0;
+		rHat = u[j + n - 1] + v[n - 1];
+		rHatOverflow = rHat < v[n - 1];
+	    } else
+		qHat = divChunks(u[j + n], u[j + n - 1], v[n - 1], rHat);
+
+	    while (!rHatOverflow) {
+		CHUNK high = 0;
+		CHUNK low = mulChunks(qHat, v[n - 2], high);
+
+		if (high < rHat || (high == rHat && low <= u[j + n - 2]))
+		    break;
+		--qHat;
+		rHat += v[n - 1];
+		rHatOverflow = rHat < v[n - 1];
+	    }
+
+	    // u[j..j+n] -= qHat * v
+	    CHUNK carry = 0;
+	    CHUNK borrow = 0;
+	    for (i = 0; i < n; ++i) {
+		CHUNK high = 0;
+		CHUNK low = mulChunks(qHat, v[i], high);
+
+		low += carry;
+		high += low < carry;
+		carry = high;
+
+		CHUNK digit = u[i + j] - low;
+		CHUNK outBorrow = u[i + j] < low;
+		outBorrow += digit < borrow;
+		u[i + j] = digit - borrow;
+		borrow = outBorrow;
+	    }
+	    CHUNK top = u[j + n] - carry;
+	    CHUNK outBorrow = u[j + n] < carry;
+	    outBorrow += top < borrow;
+	    u[j + n] = top - borrow;
+
+	    if (outBorrow) {	// qHat was one too large; add v back
+		--qHat;
+		carry = 0;
+		for (i = 0; i < n; ++i) {
+		    CHUNK digit = u[i + j] + v[i];
+		    CHUNK outCarry = digit < v[i];
+		    digit += carry;
+		    outCarry |= digit < carry;
+		    u[i + j] = digit;
+		    carry = outCarry;
+		}
+		u[j + n] += carry;
+	    }
+	    quotient.limbs[j] = qHat;
+	}
+
+	// the remainder is what is left of u, shifted back down
+	for (i = 0; i < n; ++i)
+	    remainder.limbs[i] = (u[i] >> shift)
+		| (shift ? u[i + 1] << (BitsPerChunk - shift) : 0);
+    }
+
+    static BIGINT_CONSTEXPR14 int compareUnsigned(const FixedInt &a,
+						  const FixedInt &b)
+    {
+	unsigned i = Limbs;
+
+	for (; i > 0; --i)
+	    if (a.limbs[i - 1] != b.limbs[i - 1])
+		return a.limbs[i - 1] < b.limbs[i - 1] ? -1 : 1;
+	return 0;
+    }
+
+    // two's complement magnitude; the most negative value maps to itself
+    BIGINT_CONSTEXPR14 FixedInt magnitude() const
+    {
+	return isNegative() ? -*this : *this;
+    }
+
+    public:
+    /****************
+     * Constructors *
+     ****************/
+    constexpr FixedInt() :limbs()
+    {
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt(const int val) :limbs()
+    {
+	setChunk((CHUNK) (long long) val, val < 0);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt(const unsigned int val) :limbs()
+    {
+	setChunk(val, false);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt(const long val) :limbs()
+    {
+	setChunk((CHUNK) (long long) val, val < 0);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt(const unsigned long val) :limbs()
+    {
+	setChunk(val, false);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt(const long long val) :limbs()
+    {
+	setChunk((CHUNK) val, val < 0);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt(const unsigned long long val) :limbs()
+    {
+	setChunk(val, false);
+    }
+
+    FixedInt(const std::string numStr) :limbs()
+    {
+	*this = parse(numStr.c_str());
+    }
+
+    /**************************************************
+     * the low Bits bits of value, negatives in two's *
+     * complement; only the limbs that fit are copied *
+     **************************************************/
+    explicit FixedInt(const BigInteger &value) :limbs()
+    {
+	unsigned i = 0;
+
+	for (; i < Limbs && i < value.magnitude.size(); ++i)
+	    limbs[i] = value.magnitude[i];
+	if (value.sign == BigInteger::Negative)
+	    *this = -*this;
+    }
+
+    BigInteger toBigInteger() const
+    {
+	FixedInt absolute = magnitude();
+	BigInteger answer;
+
+	answer.magnitude.assign(absolute.limbs,
+				absolute.limbs + absolute.usedLimbs());
+	if (isNegative())
+	    answer.sign = BigInteger::Negative;
+	return answer;
+    }
+
+    /***************************************************************
+     * parse a numeric string as the BigInteger constructor does:  *
+     * optional sign, then 0x for hex, a leading 0 for octal, or   *
+     * decimal; parsing stops at the first character that is not a *
+     * digit in that radix, and values too large for Bits wrap     *
+     ***************************************************************/
+    static BIGINT_CONSTEXPR14 FixedInt parse(const char *numStr)
+    {
+	FixedInt answer;
+	bool negative = false;
+	unsigned radix = 10;
+
+	if (*numStr == '-' || *numStr == '+')
+	    negative = *numStr++ == '-';
+	if (numStr[0] == '0' && (numStr[1] == 'x' || numStr[1] == 'X')) {
+	    radix = 16;
+	    numStr += 2;
+	} else if (numStr[0] == '0') {
+	    radix = 8;
+	    ++numStr;
+	}
+
+	for (; *numStr; ++numStr) {
+	    char c = *numStr;
+	    unsigned digit = radix;
+
+	    if (c >= '0' && c <= '9')
+		digit = c - '0';
+	    else if (c >= 'a' && c <= 'f')
+		digit = c - 'a' + 10;
+	    else if (c >= 'A' && c <= 'F')
+		digit = c - 'A' + 10;
+	    if (digit >= radix)
+		break;
+	    answer = multiplyLimbs(answer, FixedInt(radix));
+	    answer.addLimbs(FixedInt(digit), false, 0);
+	}
+	return negative ? -answer : answer;
+    }
+
+    /*************
+     * Accessors *
+     *************/
+    BIGINT_CONSTEXPR14 CHUNK limb(unsigned i) const
+    {
+	return limbs[i];
+    }
+
+    BIGINT_CONSTEXPR14 unsigned limbCount() const
+    {
+	return Limbs;
+    }
+
+    BIGINT_CONSTEXPR14 bool isNegative() const
+    {
+	return Signed && (limbs[Limbs - 1] >> (BitsPerChunk - 1));
+    }
+
+    BIGINT_CONSTEXPR14 bool isZero() const
+    {
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i)
+	    if (limbs[i])
+		return false;
+	return true;
+    }
+
+    /*************
+     * Operators *
+     *************/
+    BIGINT_CONSTEXPR14 bool operator== (const FixedInt &other) const
+    {
+	return compareUnsigned(*this, other) == 0;
+    }
+
+    BIGINT_CONSTEXPR14 bool operator!= (const FixedInt &other) const
+    {
+	return compareUnsigned(*this, other) != 0;
+    }
+
+    BIGINT_CONSTEXPR14 bool operator< (const FixedInt &other) const
+    {
+	if (isNegative() != other.isNegative())
+	    return isNegative();
+	return compareUnsigned(*this, other) < 0;
+    }
+
+    BIGINT_CONSTEXPR14 bool operator> (const FixedInt &other) const
+    {
+	return other < *this;
+    }
+
+    BIGINT_CONSTEXPR14 bool operator<= (const FixedInt &other) const
+    {
+	return !(other < *this);
+    }
+
+    BIGINT_CONSTEXPR14 bool operator>= (const FixedInt &other) const
+    {
+	return !(*this < other);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator+= (const FixedInt &other)
+    {
+	addLimbs(other, false, 0);
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator-= (const FixedInt &other)
+    {
+	addLimbs(other, true, 1);
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator+ (const FixedInt &other) const
+    {
+	FixedInt answer(*this);
+
+	answer += other;
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator- (const FixedInt &other) const
+    {
+	FixedInt answer(*this);
+
+	answer -= other;
+	return answer;
+    }
+
+    // Unary minus operator
+    BIGINT_CONSTEXPR14 FixedInt operator- () const
+    {
+	FixedInt answer;
+
+	answer -= *this;
+	return answer;
+    }
+
+    // Unary plus operator
+    BIGINT_CONSTEXPR14 FixedInt operator+ () const
+    {
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator++ () 	// pre-increment
+    {
+	addLimbs(FixedInt(), false, 1);
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator++ (int)	// post-increment
+    {
+	FixedInt retVal = *this;
+	++*this;
+	return retVal;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator-- () 	// pre-decrement
+    {
+	addLimbs(FixedInt(), true, 0);
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator-- (int)	// post-decrement
+    {
+	FixedInt retVal = *this;
+	--*this;
+	return retVal;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator* (const FixedInt &other) const
+    {
+	return multiplyLimbs(*this, other);
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator*= (const FixedInt &other)
+    {
+	*this = multiplyLimbs(*this, other);
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator/ (const FixedInt &other) const
+    {
+	FixedInt quotient, remainder;
+
+	if (other.isZero())
+	    throw("divide by zero");
+	divideLimbs(magnitude(), other.magnitude(), quotient, remainder);
+	return isNegative() != other.isNegative() ? -quotient : quotient;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator/= (const FixedInt &other)
+    {
+	*this = *this / other;
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator% (const FixedInt &other) const
+    {
+	FixedInt quotient, remainder;
+
+	if (other.isZero())
+	    throw("divide by zero");
+	divideLimbs(magnitude(), other.magnitude(), quotient, remainder);
+	return remainder;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator%= (const FixedInt &other)
+    {
+	*this = *this % other;
+	return *this;
+    }
+
+    /**************************************************************
+     * shifts move whole limbs and then bits; shifting by Bits or *
+     * more leaves zero, or all ones for a negative value shifted *
+     * right (shifts of a Signed FixedInt are arithmetic)         *
+     **************************************************************/
+    BIGINT_CONSTEXPR14 FixedInt& operator<<= (unsigned shiftAmount)
+    {
+	unsigned limbShift = shiftAmount / BitsPerChunk;
+	unsigned bitShift = shiftAmount % BitsPerChunk;
+	unsigned i = Limbs;
+
+	for (; i > 0; --i) {
+	    unsigned index = i - 1;
+	    CHUNK value = 0;
+
+	    if (index >= limbShift) {
+		value = limbs[index - limbShift] << bitShift;
+		if (bitShift && index > limbShift)
+		    value |= limbs[index - limbShift - 1]
+			>> (BitsPerChunk - bitShift);
+	    }
+	    limbs[index] = value;
+	}
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator<< (unsigned shiftAmount) const
+    {
+	FixedInt answer(*this);
+
+	answer <<= shiftAmount;
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator>>= (unsigned shiftAmount)
+    {
+	unsigned limbShift = shiftAmount / BitsPerChunk;
+	unsigned bitShift = shiftAmount % BitsPerChunk;
+	CHUNK fill = isNegative() ? ~(CHUNK) 0 : 0;
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i) {
+	    CHUNK low = i + limbShift < Limbs ? limbs[i + limbShift] : fill;
+	    CHUNK high = i + limbShift + 1 < Limbs
+			 ? limbs[i + limbShift + 1] : fill;
+
+	    limbs[i] = bitShift
+		? (low >> bitShift) | (high << (BitsPerChunk - bitShift))
+		: low;
+	}
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator>> (unsigned shiftAmount) const
+    {
+	FixedInt answer(*this);
+
+	answer >>= shiftAmount;
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator|= (const FixedInt &other)
+    {
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i)
+	    limbs[i] |= other.limbs[i];
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator| (const FixedInt &other) const
+    {
+	FixedInt answer(*this);
+
+	answer |= other;
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator&= (const FixedInt &other)
+    {
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i)
+	    limbs[i] &= other.limbs[i];
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator& (const FixedInt &other) const
+    {
+	FixedInt answer(*this);
+
+	answer &= other;
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt& operator^= (const FixedInt &other)
+    {
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i)
+	    limbs[i] ^= other.limbs[i];
+	return *this;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator^ (const FixedInt &other) const
+    {
+	FixedInt answer(*this);
+
+	answer ^= other;
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 FixedInt operator~ () const
+    {
+	FixedInt answer(*this);
+	unsigned i = 0;
+
+	for (; i < Limbs; ++i)
+	    answer.limbs[i] = ~answer.limbs[i];
+	return answer;
+    }
+
+    BIGINT_CONSTEXPR14 bool operator&& (const FixedInt &other) const
+    {
+	return !isZero() && !other.isZero();
+    }
+
+    BIGINT_CONSTEXPR14 bool operator|| (const FixedInt &other) const
+    {
+	return !isZero() || !other.isZero();
+    }
+};
+
+template <unsigned Bits, bool Signed>
+inline std::ostream& operator<< (std::ostream &strm,
+				 const FixedInt<Bits, Signed> &value)
+{
+    value.toBigInteger().writeTo(strm);
+    return strm;
+}
+
+// the common widths
+typedef FixedInt<128> UInt128;
+typedef FixedInt<256> UInt256;
+typedef FixedInt<512> UInt512;
+typedef FixedInt<128, true> Int128;
+typedef FixedInt<256, true> Int256;
+typedef FixedInt<512, true> Int512;
+
+/*******************************************************************
+ * Residue number system                                           *
+ * An RnsBasis is a set of distinct primes just below 2^62 whose   *
+ * product M covers a chosen signed range.  A value is held as its *
+ * residue modulo each prime, so +, - and * work one word at a     *
+ * time with no carries between them; conversion in and out goes   *
+ * through a subproduct tree of the primes:                        *
+ *   in:  a remainder tree, reducing the value down the tree       *
+ *   out: CRT as a linear combination up the tree                  *
+ * Long nodes keep a reciprocal, so that reducing by them costs a  *
+ * few Karatsuba products rather than a quadratic long division;   *
+ * without it the tree would be no faster than one prime at a time *
+ * see: Bernstein, "Fast multiplication and its applications",     *
+ * Algorithmic Number Theory, MSRI Publications 44, 2008           *
+ *******************************************************************/
+class RnsBasis
+{
+    private:
+    std::vector<CHUNK> primes;
+    // tree[0] holds the primes, tree[level][i] the product of
+    // tree[level - 1][2i] and tree[level - 1][2i + 1]; the last
+    // node of a level with an odd count is carried up unchanged
+    std::vector<std::vector<std::vector<CHUNK> > > tree;
+    // reciprocal(node) for each node of KaratsubaThreshold limbs or
+    // more, laid out as tree; shorter nodes have none
+    std::vector<std::vector<std::vector<CHUNK> > > reciprocals;
+    std::vector<CHUNK> crtInverse;	// (M / p)^-1 mod p, per prime
+    BigInteger modulusValue;		// M
+    BigInteger halfModulus;		// floor(M / 2)
+
+    static const CHUNK FirstCandidate = (1ULL << 62) - 1;
+    static const unsigned BitsPerPrime = 61;	// each prime exceeds 2^61
+
+    static BigInteger fromMagnitude(const std::vector<CHUNK> &digits)
+    {
+	BigInteger answer;
+
+	answer.magnitude = digits;
+	BigInteger::trimMagnitude(answer.magnitude);
+	return answer;
+    }
+
+    static std::vector<CHUNK> remainder(const std::vector<CHUNK> &value,
+					const std::vector<CHUNK> &divisor)
+    {
+	std::vector<CHUNK> quotient, rem;
+
+	BigInteger::divideMagnitudes(value, divisor, quotient, rem);
+	return rem;
+    }
+
+    /****************************************************************
+     * floor(B^2k / m) for m of k limbs, B = 2^64, by Newton's      *
+     * iteration: the reciprocal of m's top half, scaled up, is     *
+     * refined by one step x += x (B^2k - m x) / B^2k, which about  *
+     * doubles its correct limbs, and a last division by m, whose   *
+     * quotient is only a unit or two, makes it exact.  The top     *
+     * half keeps two extra limbs so that one step is enough        *
+     ****************************************************************/
+    static std::vector<CHUNK> reciprocal(const std::vector<CHUNK> &m)
+    {
+	ULONG k = m.size();
+	std::vector<CHUNK> power(2 * k + 1, 0);
+	std::vector<CHUNK> x, product, error, quotient, rem;
+
+	power[2 * k] = 1;
+	if (k < BigInteger::KaratsubaThreshold) {
+	    BigInteger::divideMagnitudes(power, m, x, rem);
+	    return x;
+	}
+
+	ULONG half = k / 2 + 2;
+
+	x = reciprocal(std::vector<CHUNK>(m.end() - half, m.end()));
+	BigInteger::shiftMagnitudeLeft(x,
+				       (k - half) * BigInteger::BitsPerChunk);
+
+	BigInteger::multiplyMagnitudes(m, x, product);
+	bool over = BigInteger::compareMagnitudes(product, power) > 0;
+	if (over) {
+	    error = product;
+	    BigInteger::subtractMagnitudeFrom(error, power);
+	} else {
+	    error = power;
+	    BigInteger::subtractMagnitudeFrom(error, product);
+	}
+	BigInteger::multiplyMagnitudes(x, error, product);
+	BigInteger::shiftMagnitudeRight(product,
+					k * 2 * BigInteger::BitsPerChunk);
+	if (over)
+	    BigInteger::subtractMagnitudeFrom(x, product);
+	else
+	    BigInteger::addMagnitudeAt(x, product, 0);
+
+	BigInteger::multiplyMagnitudes(m, x, product);
+	if (BigInteger::compareMagnitudes(product, power) > 0) {
+	    // too large: take off ceil((m x - B^2k) / m)
+	    BigInteger::subtractMagnitudeFrom(product, power);
+	    BigInteger::divideMagnitudes(product, m, quotient, rem);
+	    if (rem.size() > 1 || rem[0])
+		BigInteger::addMagnitudeAt(quotient,
+					   std::vector<CHUNK>(1, 1), 0);
+	    BigInteger::subtractMagnitudeFrom(x, quotient);
+	} else {
+	    error = power;
+	    BigInteger::subtractMagnitudeFrom(error, product);
+	    BigInteger::divideMagnitudes(error, m, quotient, rem);
+	    BigInteger::addMagnitudeAt(x, quotient, 0);
+	}
+	BigInteger::trimMagnitude(x);
+	return x;
+    }
+
+    /*******************************************************************
+     * value mod m for m of k limbs, given mu = reciprocal(m).  Each   *
+     * quotient estimate floor(floor(x / B^(k-1)) mu / B^(k+1)) is at  *
+     * most two short when x < B^2k, so a longer value is taken from   *
+     * the top, 2k limbs and then k at a time below the remainder      *
+     * see: Menezes, van Oorschot and Vanstone, Handbook of Applied    *
+     * Cryptography, CRC Press, 1996, algorithm 14.42                  *
+     *******************************************************************/
+    static std::vector<CHUNK> barrettRemainder(const std::vector<CHUNK> &value,
+					       const std::vector<CHUNK> &m,
+					       const std::vector<CHUNK> &mu)
+    {
+	ULONG k = m.size();
+	ULONG end = value.size();
+	ULONG take = 2 * k;
+	std::vector<CHUNK> rem(1, 0), part, estimate, product;
+
+	while (end > 0) {
+	    ULONG start = end > take ? end - take : 0;
+
+	    part.assign(value.begin() + start, value.begin() + end);
+	    part.insert(part.end(), rem.begin(), rem.end());
+	    BigInteger::trimMagnitude(part);
+	    end = start;
+	    take = k;
+	    if (part.size() >= k) {
+		estimate.assign(part.begin() + (k - 1), part.end());
+		BigInteger::multiplyMagnitudes(estimate, mu, product);
+		BigInteger::shiftMagnitudeRight(product, (k + 1)
+						* BigInteger::BitsPerChunk);
+		BigInteger::multiplyMagnitudes(product, m, estimate);
+		BigInteger::subtractMagnitudeFrom(part, estimate);
+		while (BigInteger::compareMagnitudes(part, m) >= 0)
+		    BigInteger::subtractMagnitudeFrom(part, m);
+	    }
+	    rem.swap(part);
+	}
+	return rem;
+    }
+
+    // value mod tree[level][index]
+    std::vector<CHUNK> reduce(const std::vector<CHUNK> &value, ULONG level,
+			      ULONG index) const
+    {
+	const std::vector<CHUNK> &mu = reciprocals[level][index];
+
+	if (mu.empty())
+	    return remainder(value, tree[level][index]);
+	return barrettRemainder(value, tree[level][index], mu);
+    }
+
+    /********************************************************
+     * Miller-Rabin with the first twelve primes as bases,  *
+     * which is deterministic for every n below 3.3 * 10^24 *
+     ********************************************************/
+    static bool isPrimeChunk(CHUNK n)
+    {
+	static const CHUNK bases[] = {
+	    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37
+	};
+	CHUNK d = n - 1;
+	unsigned s = 0, i, r;
+
+	for (i = 0; i < sizeof(bases) / sizeof(bases[0]); ++i)
+	    if (n % bases[i] == 0)
+		return n == bases[i];
+	while (!(d & 1)) {
+	    d >>= 1;
+	    ++s;
+	}
+	for (i = 0; i < sizeof(bases) / sizeof(bases[0]); ++i) {
+	    CHUNK x = powMod(bases[i], d, n);
+
+	    if (x == 1 || x == n - 1)
+		continue;
+	    for (r = 1; r < s && x != n - 1; ++r)
+		x = mulMod(x, x, n);
+	    if (x != n - 1)
+		return false;
+	}
+	return true;
+    }
+
+    /***************************************************************
+     * value is below the product of tree[level][index]; store its *
+     * residues for the primes under that node                     *
+     ***************************************************************/
+    void descend(ULONG level, ULONG index, const std::vector<CHUNK> &value,
+		 std::vector<CHUNK> &residues) const
+    {
+	ULONG child;
+
+	if (level == 0) {
+	    residues[index] = value[0];
+	    return;
+	}
+	for (child = 2 * index;
+	     child < tree[level - 1].size() && child <= 2 * index + 1; ++child)
+	    descend(level - 1, child, reduce(value, level - 1, child),
+		    residues);
+    }
+
+    /************************************************************
+     * sum of weights[i] * (product of the node / p_i) over the *
+     * primes under tree[level][index]                          *
+     ************************************************************/
+    BigInteger combine(ULONG level, ULONG index,
+		       const std::vector<CHUNK> &weights) const
+    {
+	std::vector<CHUNK> product;
+
+	if (level == 0)
+	    return BigInteger(weights[index]);
+	if (2 * index + 1 >= tree[level - 1].size())	// carried up
+	    return combine(level - 1, 2 * index, weights);
+
+	BigInteger left = combine(level - 1, 2 * index, weights);
+	BigInteger right = combine(level - 1, 2 * index + 1, weights);
+
+	BigInteger::multiplyMagnitudes(left.magnitude,
+				       tree[level - 1][2 * index + 1], product);
+	left = fromMagnitude(product);
+	BigInteger::multiplyMagnitudes(right.magnitude,
+				       tree[level - 1][2 * index], product);
+	return left + fromMagnitude(product);
+    }
+
+    /******************************************************************
+     * cofactor is (M / product of the node) mod product of the node; *
+     * at the leaves that is (M / p) mod p, whose inverse CRT needs   *
+     ******************************************************************/
+    void cofactors(ULONG level, ULONG index,
+		   const std::vector<CHUNK> &cofactor)
+    {
+	std::vector<CHUNK> product;
+	ULONG child;
+
+	if (level == 0) {
+	    crtInverse[index] = powMod(cofactor[0], primes[index] - 2,
+				       primes[index]);
+	    return;
+	}
+	for (child = 2 * index;
+	     child < tree[level - 1].size() && child <= 2 * index + 1; ++child) {
+	    ULONG sibling = child ^ 1;
+
+	    if (sibling < tree[level - 1].size()) {
+		BigInteger::multiplyMagnitudes(cofactor,
+					       tree[level - 1][sibling],
+					       product);
+		cofactors(level - 1, child, reduce(product, level - 1, child));
+	    } else
+		cofactors(level - 1, child, cofactor);
+	}
+    }
+
+    public:
+    /*********************************************************
+     * enough primes to hold any value of up to 'bits' bits, *
+     * of either sign                                        *
+     *********************************************************/
+    explicit RnsBasis(ULONG bits)
+    {
+	ULONG count = (bits + 1) / BitsPerPrime + 1;
+	CHUNK candidate;
+	ULONG level, i;
+
+	for (candidate = FirstCandidate; primes.size() < count; candidate -= 2)
+	    if (isPrimeChunk(candidate))
+		primes.push_back(candidate);
+
+	tree.push_back(std::vector<std::vector<CHUNK> >());
+	for (i = 0; i < count; ++i)
+	    tree[0].push_back(std::vector<CHUNK>(1, primes[i]));
+	reciprocals.push_back(std::vector<std::vector<CHUNK> >(count));
+	for (level = 0; tree[level].size() > 1; ++level) {
+	    const std::vector<std::vector<CHUNK> > &below = tree[level];
+	    std::vector<std::vector<CHUNK> > above((below.size() + 1) / 2);
+	    std::vector<std::vector<CHUNK> > inverses(above.size());
+
+	    for (i = 0; i + 1 < below.size(); i += 2) {
+		BigInteger::multiplyMagnitudes(below[i], below[i + 1],
+					       above[i / 2]);
+		if (above[i / 2].size() >= BigInteger::KaratsubaThreshold)
+		    inverses[i / 2] = reciprocal(above[i / 2]);
+	    }
+	    if (below.size() % 2) {
+		above.back() = below.back();
+		inverses.back() = reciprocals[level].back();
+	    }
+	    tree.push_back(above);
+	    reciprocals.push_back(inverses);
+	}
+
+	modulusValue = fromMagnitude(tree.back()[0]);
+	halfModulus = modulusValue >> BigInteger(1);
+	crtInverse.resize(count);
+	cofactors(tree.size() - 1, 0, std::vector<CHUNK>(1, 1));
+    }
+
+    ULONG size() const
+    {
+	return primes.size();
+    }
+
+    CHUNK prime(ULONG i) const
+    {
+	return primes[i];
+    }
+
+    const BigInteger &modulus() const
+    {
+	return this->modulusValue;
+    }
+
+    // (a * b) mod p; a and b must already be below p
+    static CHUNK mulMod(CHUNK a, CHUNK b, CHUNK p)
+    {
+	CHUNK high;
+	CHUNK low = mulChunks(a, b, high);
+	CHUNK rem;
+
+	divChunks(high, low, p, rem);
+	return rem;
+    }
+
+    static CHUNK powMod(CHUNK base, CHUNK exponent, CHUNK p)
+    {
+	CHUNK result = 1;
+
+	for (; exponent; exponent >>= 1) {
+	    if (exponent & 1)
+		result = mulMod(result, base, p);
+	    base = mulMod(base, base, p);
+	}
+	return result;
+    }
+
+    // residues of value, one per prime, reduced to [0, p)
+    void toResidues(const BigInteger &value,
+		    std::vector<CHUNK> &residues) const
+    {
+	ULONG i;
+
+	residues.resize(primes.size());
+	descend(tree.size() - 1, 0,
+		reduce(value.magnitude, tree.size() - 1, 0), residues);
+	if (value.sign == BigInteger::Negative)
+	    for (i = 0; i < residues.size(); ++i)
+		if (residues[i])
+		    residues[i] = primes[i] - residues[i];
+    }
+
+    /********************************************************************
+     * the value in (-M/2, M/2] with these residues, by CRT:            *
+     * sum of (r * (M/p)^-1 mod p) * M/p over the primes, reduced mod M *
+     ********************************************************************/
+    BigInteger fromResidues(const std::vector<CHUNK> &residues) const
+    {
+	std::vector<CHUNK> weights(primes.size());
+	ULONG i;
+
+	if (residues.size() != primes.size())
+	    throw("residue count does not match the basis");
+	for (i = 0; i < primes.size(); ++i)
+	    weights[i] = mulMod(residues[i] % primes[i], crtInverse[i],
+				primes[i]);
+
+	BigInteger sum = combine(tree.size() - 1, 0, weights);
+	BigInteger answer = fromMagnitude(reduce(sum.magnitude,
+						 tree.size() - 1, 0));
+	if (answer > halfModulus)
+	    answer -= modulusValue;
+	return answer;
+    }
+};
+
+/*****************************************************************
+ * a value in residue form over an RnsBasis; arithmetic is exact *
+ * as long as every intermediate fits the basis's range, and     *
+ * long residue vectors are split across threads.  The basis     *
+ * must outlive its values.                                      *
+ *****************************************************************/
+class RnsInteger
+{
+    private:
+    const RnsBasis *basis;
+    std::vector<CHUNK> residues;
+
+    static const size_t ParallelGrainSize = 4096;
+
+    enum Operation {
+	Add,
+	Subtract,
+	Multiply
+    };
+
+    void checkBasis(const RnsInteger &other) const
+    {
+	if (this->basis != other.basis)
+	    throw("RNS values use different bases");
+    }
+
+    void apply(Operation operation, const RnsInteger &other)
+    {
+	const RnsBasis &primes = *this->basis;
+	std::vector<CHUNK> &mine = this->residues;
+	const std::vector<CHUNK> &theirs = other.residues;
+
+	checkBasis(other);
+	parallelFor(mine.size(), ParallelGrainSize,
+		    [&](size_t begin, size_t end)
+	{
+	    size_t i;
+
+	    for (i = begin; i < end; ++i) {
+		CHUNK p = primes.prime(i);
+
+		if (operation == Add)
+		    mine[i] = mine[i] + theirs[i] >= p
+			      ? mine[i] + theirs[i] - p : mine[i] + theirs[i];
+		else if (operation == Subtract)
+		    mine[i] = mine[i] >= theirs[i]
+			      ? mine[i] - theirs[i] : mine[i] + p - theirs[i];
+		else
+		    mine[i] = RnsBasis::mulMod(mine[i], theirs[i], p);
+	    }
+	});
+    }
+
+    public:
+    RnsInteger(const RnsBasis &basisArg,
+	       const BigInteger &value = BigInteger(0))
+	:basis(&basisArg)
+    {
+	basisArg.toResidues(value, this->residues);
+    }
+
+    const RnsBasis &rnsBasis() const
+    {
+	return *this->basis;
+    }
+
+    CHUNK residue(ULONG i) const
+    {
+	return this->residues[i];
+    }
+
+    BigInteger toBigInteger() const
+    {
+	return this->basis->fromResidues(this->residues);
+    }
+
+    /*************
+     * Operators *
+     *************/
+    RnsInteger& operator+= (const RnsInteger &other)
+    {
+	apply(Add, other);
+	return *this;
+    }
+
+    RnsInteger& operator-= (const RnsInteger &other)
+    {
+	apply(Subtract, other);
+	return *this;
+    }
+
+    RnsInteger& operator*= (const RnsInteger &other)
+    {
+	apply(Multiply, other);
+	return *this;
+    }
+
+    RnsInteger operator+ (const RnsInteger &other) const
+    {
+	RnsInteger answer(*this);
+
+	answer += other;
+	return answer;
+    }
+
+    RnsInteger operator- (const RnsInteger &other) const
+    {
+	RnsInteger answer(*this);
+
+	answer -= other;
+	return answer;
+    }
+
+    RnsInteger operator* (const RnsInteger &other) const
+    {
+	RnsInteger answer(*this);
+
+	answer *= other;
+	return answer;
+    }
+
+    // Unary minus operator
+    RnsInteger operator- () const
+    {
+	RnsInteger answer(*this->basis);
+
+	answer -= *this;
+	return answer;
+    }
+
+    bool operator== (const RnsInteger &other) const
+    {
+	checkBasis(other);
+	return this->residues == other.residues;
+    }
+
+    bool operator!= (const RnsInteger &other) const
+    {
+	return !(*this == other);
+    }
+};
+
+inline std::ostream& operator<< (std::ostream &strm, const RnsInteger &value)
+{
+    value.toBigInteger().writeTo(strm);
+    return strm;
+}
+
+/*******************************************************************
+ * Decimal-native integers                                         *
+ * A BigDecimalInteger keeps its magnitude in base 10^19, the      *
+ * largest power of ten below 2^64, least significant limb first.  *
+ * Parsing and printing only group or split 19 digits per limb,    *
+ * and +, -, * and the comparisons work on those limbs directly,   *
+ * so decimal text that is summed, scaled and printed again never  *
+ * goes through a radix conversion.  For heavier arithmetic, the   *
+ * conversions to and from BigInteger split the value in halves at *
+ * powers of 10^19 (or of 2^64) and recombine them with Karatsuba  *
+ * products, so they take O(M(n) log n) rather than O(n^2) time    *
+ *******************************************************************/
+class BigDecimalInteger
+{
+    private:
+    std::vector<CHUNK> limbs;	// each below Base
+    BigInteger::Sign sign;
+
+    static const CHUNK Base = 10000000000000000000ULL;	// 10^19
+    static const unsigned DigitsPerLimb = 19;
+    static const ULONG ConversionLeafLimbs = 32;
+
+    bool isZero() const
+    {
+	return this->limbs.size() == 1 && this->limbs[0] == 0;
+    }
+
+    // trim the limbs and keep zero positive
+    void normalize()
+    {
+	BigInteger::trimMagnitude(this->limbs);
+	if (isZero())
+	    this->sign = BigInteger::Positive;
+    }
+
+    // digits += addend * Base^offset, growing digits as needed
+    static void addLimbsAt(std::vector<CHUNK> &digits,
+			   const std::vector<CHUNK> &addend, ULONG offset)
+    {
+	CHUNK carry = 0;
+	ULONG i;
+
+	if (digits.size() < offset + addend.size())
+	    digits.resize(offset + addend.size(), 0);
+	for (i = 0; i < addend.size(); ++i) {
+	    CHUNK sum = digits[offset + i] + carry;	// at most Base
+	    CHUNK room = Base - addend[i];	// the most that needs no carry
+
+	    carry = sum >= room;
+	    digits[offset + i] = carry ? sum - room : sum + addend[i];
+	}
+	for (i += offset; carry && i < digits.size(); ++i) {
+	    carry = digits[i] == Base - 1;
+	    digits[i] = carry ? 0 : digits[i] + 1;
+	}
+	if (carry)
+	    digits.push_back(1);
+    }
+
+    // digits -= subtrahend; both trimmed, and digits the larger
+    static void subtractLimbs(std::vector<CHUNK> &digits,
+			      const std::vector<CHUNK> &subtrahend)
+    {
+	CHUNK borrow = 0;
+	ULONG i;
+
+	for (i = 0; i < subtrahend.size(); ++i) {
+	    CHUNK take = subtrahend[i] + borrow;	// at most Base
+
+	    borrow = digits[i] < take;
+	    digits[i] = borrow ? digits[i] + (Base - take) : digits[i] - take;
+	}
+	for (; borrow && i < digits.size(); ++i) {
+	    borrow = digits[i] == 0;
+	    digits[i] = borrow ? Base - 1 : digits[i] - 1;
+	}
+	BigInteger::trimMagnitude(digits);
+    }
+
+    /***************************************************************
+     * digits *= factor, in place; each limb product plus carry is *
+     * below Base * 2^64, so one double-width division splits it   *
+     ***************************************************************/
+    static void multiplyLimbsByChunk(std::vector<CHUNK> &digits,
+				     CHUNK factor)
+    {
+	CHUNK carry = 0;
+	ULONG i;
+
+	for (i = 0; i < digits.size(); ++i) {
+	    CHUNK high;
+	    CHUNK low = mulChunks(digits[i], factor, high);
+
+	    low += carry;
+	    high += low < carry;
+	    carry = divChunks(high, low, Base, digits[i]);
+	}
+	for (; carry; carry /= Base)
+	    digits.push_back(carry % Base);
+	BigInteger::trimMagnitude(digits);
+    }
+
+    /******************************************************************
+     * product by columns: each column's limb products are summed in  *
+     * three words exactly, and only then split by Base into the      *
+     * column's limb and the carry into the next, so the costly       *
+     * double-width divisions are per limb of the product rather      *
+     * than per limb product.  Karatsuba takes over for long operands *
+     ******************************************************************/
+    static void multiplyLimbs(const std::vector<CHUNK> &a,
+			      const std::vector<CHUNK> &b,
+			      std::vector<CHUNK> &product)
+    {
+	CHUNK low = 0, middle = 0, top = 0;
+	ULONG k, i;
+
+	// the same cutoff as the binary kernel: both do n^2 limb products
+	if (a.size() >= BigInteger::KaratsubaThreshold
+	    && b.size() >= BigInteger::KaratsubaThreshold) {
+	    karatsubaLimbs(a, b, product);
+	    return;
+	}
+
+	product.resize(a.size() + b.size());
+	for (k = 0; k + 1 < a.size() + b.size(); ++k) {
+	    ULONG first = k < b.size() ? 0 : k - b.size() + 1;
+	    ULONG last = k < a.size() ? k : a.size() - 1;
+	    CHUNK remainder;
+
+	    for (i = first; i <= last; ++i) {
+		CHUNK high;
+		CHUNK part = mulChunks(a[i], b[k - i], high);
+
+		low += part;
+		high += low < part;
+		middle += high;
+		top += middle < high;
+	    }
+	    remainder = top;	// top is below Base: it counts overflows
+	    middle = divChunks(remainder, middle, Base, remainder);
+	    low = divChunks(remainder, low, Base, remainder);
+	    top = 0;
+	    product[k] = remainder;
+	}
+	product[k] = low;	// the last carry is a single limb
+	BigInteger::trimMagnitude(product);
+    }
+
+    /**************************************************************
+     * Karatsuba in base 10^19, as BigInteger::karatsubaMultiply: *
+     * z0 = a0 b0, z2 = a1 b1, z1 = (a0 + a1)(b0 + b1) - z0 - z2, *
+     * and slices of the longer operand when the shorter is no    *
+     * more than half its length                                  *
+     **************************************************************/
+    static void karatsubaLimbs(const std::vector<CHUNK> &a,
+			       const std::vector<CHUNK> &b,
+			       std::vector<CHUNK> &product)
+    {
+	const std::vector<CHUNK> &longer = a.size() >= b.size() ? a : b;
+	const std::vector<CHUNK> &shorter = a.size() >= b.size() ? b : a;
+	ULONG half = (longer.size() + 1) / 2;
+	std::vector<CHUNK> z0, z1, z2;
+
+	if (shorter.size() <= half) {
+	    ULONG offset;
+
+	    product.assign(1, 0);
+	    for (offset = 0; offset < longer.size();
+		 offset += shorter.size()) {
+		ULONG end = offset + shorter.size() < longer.size()
+			    ? offset + shorter.size() : longer.size();
+		std::vector<CHUNK> slice(longer.begin() + offset,
+					 longer.begin() + end);
+
+		BigInteger::trimMagnitude(slice);
+		multiplyLimbs(slice, shorter, z0);
+		addLimbsAt(product, z0, offset);
+	    }
+	    BigInteger::trimMagnitude(product);
+	    return;
+	}
+
+	std::vector<CHUNK> a0(longer.begin(), longer.begin() + half);
+	std::vector<CHUNK> a1(longer.begin() + half, longer.end());
+	std::vector<CHUNK> b0(shorter.begin(), shorter.begin() + half);
+	std::vector<CHUNK> b1(shorter.begin() + half, shorter.end());
+	BigInteger::trimMagnitude(a0);
+	BigInteger::trimMagnitude(a1);
+	BigInteger::trimMagnitude(b0);
+	BigInteger::trimMagnitude(b1);
+
+	multiplyLimbs(a0, b0, z0);
+	multiplyLimbs(a1, b1, z2);
+	addLimbsAt(a0, a1, 0);
+	addLimbsAt(b0, b1, 0);
+	multiplyLimbs(a0, b0, z1);
+	subtractLimbs(z1, z0);
+	subtractLimbs(z1, z2);
+
+	product.swap(z0);
+	addLimbsAt(product, z1, half);
+	addLimbsAt(product, z2, 2 * half);
+	BigInteger::trimMagnitude(product);
+    }
+
+    // the level at which a run of 'count' limbs is split: 2^level < count
+    static unsigned splitLevel(ULONG count)
+    {
+	unsigned level = 0;
+
+	while ((2ULL << level) < count)
+	    ++level;
+	return level;
+    }
+
+    /****************************************************************
+     * binary magnitude of digits[first, first + count), as         *
+     * high * 10^(19 * 2^level) + low; powers[k] = 10^(19 * 2^k) in *
+     * binary.  Short runs go by Horner's rule, top limb first      *
+     ****************************************************************/
+    static void toBinary(const std::vector<CHUNK> &digits, ULONG first,
+			 ULONG count,
+			 const std::vector<std::vector<CHUNK> > &powers,
+			 std::vector<CHUNK> &result)
+    {
+	ULONG i, j;
+
+	if (count <= ConversionLeafLimbs) {
+	    result.clear();
+	    for (i = count; i > 0; --i) {
+		CHUNK carry = digits[first + i - 1];
+
+		for (j = 0; j < result.size(); ++j) {
+		    CHUNK high;
+		    CHUNK low = mulChunks(result[j], Base, high);
+
+		    low += carry;
+		    high += low < carry;
+		    result[j] = low;
+		    carry = high;
+		}
+		if (carry)
+		    result.push_back(carry);
+	    }
+	    BigInteger::trimMagnitude(result);
+	    return;
+	}
+
+	unsigned level = splitLevel(count);
+	ULONG split = (ULONG) 1 << level;
+	std::vector<CHUNK> high, low;
+
+	toBinary(digits, first + split, count - split, powers, high);
+	toBinary(digits, first, split, powers, low);
+	BigInteger::multiplyMagnitudes(high, powers[level], result);
+	BigInteger::addMagnitudeAt(result, low, 0);
+	BigInteger::trimMagnitude(result);
+    }
+
+    /******************************************************************
+     * the reverse: decimal limbs of binary[first, first + count), as *
+     * high * 2^(64 * 2^level) + low with powers[k] = 2^(64 * 2^k) in *
+     * base 10^19.  Short runs are divided down by 10^19              *
+     ******************************************************************/
+    static void fromBinary(const std::vector<CHUNK> &binary, ULONG first,
+			   ULONG count,
+			   const std::vector<std::vector<CHUNK> > &powers,
+			   std::vector<CHUNK> &result)
+    {
+	if (count <= ConversionLeafLimbs) {
+	    std::vector<CHUNK> value(binary.begin() + first,
+				     binary.begin() + first + count);
+
+	    BigInteger::trimMagnitude(value);
+	    result.clear();
+	    while (value.size() > 1 || value[0] != 0)
+		result.push_back(BigInteger::divideMagnitudeByChunk(value,
+								     Base));
+	    BigInteger::trimMagnitude(result);
+	    return;
+	}
+
+	unsigned level = splitLevel(count);
+	ULONG split = (ULONG) 1 << level;
+	std::vector<CHUNK> high, low;
+
+	fromBinary(binary, first + split, count - split, powers, high);
+	fromBinary(binary, first, split, powers, low);
+	multiplyLimbs(high, powers[level], result);
+	addLimbsAt(result, low, 0);
+	BigInteger::trimMagnitude(result);
+    }
+
+    /****************************************************************
+     * an optional sign and then digits, up to the first non-digit, *
+     * as the BigInteger string constructor reads them              *
+     ****************************************************************/
+    void parse(const char *text, size_t length)
+    {
+	size_t start = 0, end, i, j;
+
+	this->sign = BigInteger::Positive;
+	if (length > 0 && (text[0] == '-' || text[0] == '+')) {
+	    if (text[0] == '-')
+		this->sign = BigInteger::Negative;
+	    start = 1;
+	}
+	for (end = start; end < length && text[end] >= '0' && text[end] <= '9';
+	     ++end)
+	    ;
+
+	// limb i holds the i'th group of 19 digits from the right
+	this->limbs.assign((end - start + DigitsPerLimb - 1) / DigitsPerLimb,
+			   0);
+	for (i = 0; i < this->limbs.size(); ++i) {
+	    size_t groupEnd = end - i * DigitsPerLimb;
+	    size_t groupStart = groupEnd - start > DigitsPerLimb
+				? groupEnd - DigitsPerLimb : start;
+	    CHUNK value = 0;
+
+	    for (j = groupStart; j < groupEnd; ++j)
+		value = value * 10 + (text[j] - '0');
+	    this->limbs[i] = value;
+	}
+	normalize();
+    }
+
+    // *this += other, or -= other when 'negate' is set
+    void addSigned(const BigDecimalInteger &other, bool negate)
+    {
+	BigInteger::Sign otherSign = other.sign;
+
+	if (&other == this) {
+	    BigDecimalInteger copy(other);
+
+	    addSigned(copy, negate);
+	    return;
+	}
+	if (negate)
+	    otherSign = otherSign == BigInteger::Positive
+			? BigInteger::Negative : BigInteger::Positive;
+
+	if (this->sign == otherSign)
+	    addLimbsAt(this->limbs, other.limbs, 0);
+	else if (BigInteger::compareMagnitudes(this->limbs, other.limbs) >= 0)
+	    subtractLimbs(this->limbs, other.limbs);
+	else {
+	    std::vector<CHUNK> difference(other.limbs);
+
+	    subtractLimbs(difference, this->limbs);
+	    this->limbs.swap(difference);
+	    this->sign = otherSign;
+	}
+	normalize();
+    }
+
+    public:
+    /****************
+     * Constructors *
+     ****************/
+    BigDecimalInteger(const long long val = 0)
+	:sign(val < 0 ? BigInteger::Negative : BigInteger::Positive)
+    {
+	CHUNK value = val < 0 ? -(CHUNK) val : (CHUNK) val;
+
+	this->limbs.push_back(value);	// any long long is below 10^19
+    }
+
+    BigDecimalInteger(const std::string &text)
+    {
+	parse(text.data(), text.size());
+    }
+
+    BigDecimalInteger(const char *text)
+    {
+	parse(text, std::strlen(text));
+    }
+
+    // the decimal limbs of a binary value
+    explicit BigDecimalInteger(const BigInteger &value)
+	:sign(value.sign)
+    {
+	const std::vector<CHUNK> &binary = value.magnitude;
+	std::vector<std::vector<CHUNK> > powers;
+
+	// powers[k] = 2^(64 * 2^k), as long as 2^k limbs can be split off
+	powers.push_back(std::vector<CHUNK>(2, 1));
+	powers[0][0] = (CHUNK) 0 - Base;	// 2^64 = 10^19 + this
+	while (((ULONG) 1 << powers.size()) < binary.size()) {
+	    std::vector<CHUNK> square;
+
+	    multiplyLimbs(powers.back(), powers.back(), square);
+	    powers.push_back(square);
+	}
+	fromBinary(binary, 0, binary.size(), powers, this->limbs);
+	normalize();
+    }
+
+    BigInteger toBigInteger() const
+    {
+	BigInteger answer;
+	std::vector<std::vector<CHUNK> > powers;
+
+	// powers[k] = 10^(19 * 2^k), as long as 2^k limbs can be split off
+	powers.push_back(std::vector<CHUNK>(1, Base));
+	while (((ULONG) 1 << powers.size()) < this->limbs.size()) {
+	    std::vector<CHUNK> square;
+
+	    BigInteger::squareMagnitude(powers.back(), square);
+	    powers.push_back(square);
+	}
+	toBinary(this->limbs, 0, this->limbs.size(), powers, answer.magnitude);
+	if (!isZero())
+	    answer.sign = this->sign;
+	return answer;
+    }
+
+    // number of decimal digits, not counting the sign
+    ULONG digitCount() const
+    {
+	CHUNK top = this->limbs.back();
+	ULONG count = (this->limbs.size() - 1) * DigitsPerLimb;
+
+	do {
+	    ++count;
+	    top /= 10;
+	} while (top);
+	return count;
+    }
+
+    /*****************************************************
+     * the decimal digits: the top limb as it is, every  *
+     * other limb padded with zeros to exactly 19 digits *
+     *****************************************************/
+    std::string toString() const
+    {
+	std::string text;
+	char group[DigitsPerLimb];
+	ULONG i;
+	unsigned k;
+
+	text.reserve(digitCount() + 1);
+	if (this->sign == BigInteger::Negative)
+	    text += '-';
+	text += std::to_string(this->limbs.back());
+	for (i = this->limbs.size() - 1; i > 0; --i) {
+	    CHUNK value = this->limbs[i - 1];
+
+	    for (k = DigitsPerLimb; k > 0; --k) {
+		group[k - 1] = (char) ('0' + value % 10);
+		value /= 10;
+	    }
+	    text.append(group, DigitsPerLimb);
+	}
+	return text;
+    }
+
+    // -1, 0 or 1 as *this is less than, equal to or greater than other
+    int compare(const BigDecimalInteger &other) const
+    {
+	int order;
+
+	if (this->sign != other.sign)
+	    return this->sign == BigInteger::Negative ? -1 : 1;
+	order = BigInteger::compareMagnitudes(this->limbs, other.limbs);
+	return this->sign == BigInteger::Negative ? -order : order;
+    }
+
+    /*************
+     * Operators *
+     *************/
+    BigDecimalInteger& operator+= (const BigDecimalInteger &other)
+    {
+	addSigned(other, false);
+	return *this;
+    }
+
+    BigDecimalInteger& operator-= (const BigDecimalInteger &other)
+    {
+	addSigned(other, true);
+	return *this;
+    }
+
+    BigDecimalInteger& operator*= (const BigDecimalInteger &other)
+    {
+	BigInteger::Sign productSign = this->sign == other.sign
+				       ? BigInteger::Positive
+				       : BigInteger::Negative;
+	std::vector<CHUNK> product;
+
+	// a one-limb factor, such as any long long, scales in one pass
+	if (other.limbs.size() == 1)
+	    multiplyLimbsByChunk(this->limbs, other.limbs[0]);
+	else if (this->limbs.size() == 1) {
+	    CHUNK factor = this->limbs[0];
+
+	    this->limbs = other.limbs;
+	    multiplyLimbsByChunk(this->limbs, factor);
+	} else {
+	    multiplyLimbs(this->limbs, other.limbs, product);
+	    this->limbs.swap(product);
+	}
+	this->sign = productSign;
+	normalize();
+	return *this;
+    }
+
+    BigDecimalInteger operator+ (const BigDecimalInteger &other) const
+    {
+	BigDecimalInteger answer(*this);
+
+	answer += other;
+	return answer;
+    }
+
+    BigDecimalInteger operator- (const BigDecimalInteger &other) const
+    {
+	BigDecimalInteger answer(*this);
+
+	answer -= other;
+	return answer;
+    }
+
+    BigDecimalInteger operator* (const BigDecimalInteger &other) const
+    {
+	BigDecimalInteger answer(*this);
+
+	answer *= other;
+	return answer;
+    }
+
+    // Unary minus operator
+    BigDecimalInteger operator- () const
+    {
+	BigDecimalInteger answer(*this);
+
+	if (!answer.isZero())
+	    answer.sign = this->sign == BigInteger::Positive
+			  ? BigInteger::Negative : BigInteger::Positive;
+	return answer;
+    }
+
+    bool operator== (const BigDecimalInteger &other) const
+    {
+	return this->sign == other.sign && this->limbs == other.limbs;
+    }
+
+    bool operator!= (const BigDecimalInteger &other) const
+    {
+	return !(*this == other);
+    }
+
+    bool operator< (const BigDecimalInteger &other) const
+    {
+	return compare(other) < 0;
+    }
+
+    bool operator<= (const BigDecimalInteger &other) const
+    {
+	return compare(other) <= 0;
+    }
+
+    bool operator> (const BigDecimalInteger &other) const
+    {
+	return compare(other) > 0;
+    }
+
+    bool operator>= (const BigDecimalInteger &other) const
+    {
+	return compare(other) >= 0;
+    }
+};
+
+const CHUNK BigDecimalInteger::Base;	// toBigInteger() binds it by reference
+
+// always decimal, whatever the stream's radix flags
+inline std::ostream& operator<< (std::ostream &strm,
+				 const BigDecimalInteger &value)
+{
+    std::string text = value.toString();
+
+    strm.write(text.data(), text.size());
+    return strm;
+}
+
+inline std::istream& operator>> (std::istream &strm, BigDecimalInteger &value)
+{
+    std::string text;
+
+    if (strm >> text)
+	value = BigDecimalInteger(text);
+    return strm;
+}
+
+/******************************************************************
+ * Constant-time arithmetic for secret values                     *
+ * Everything else in this file branches on the data it is given. *
+ * CtInt and CtModulus never do: every loop runs over all the     *
+ * limbs, carries come from bit operations or from unsigned       *
+ * compares that compile to add-with-carry and set-on-carry, and  *
+ * choices between two values are masked selections.  Only the    *
+ * widths, which are template parameters, and the modulus are     *
+ * treated as public.  Conversions to and from BigInteger and     *
+ * FixedInt are not constant time.                                *
+ ******************************************************************/
+
+/****************************************************************
+ * hide a value from the optimizer, so that a mask built from a *
+ * secret bit cannot be turned back into a branch               *
+ ****************************************************************/
+inline CHUNK ctBarrier(CHUNK value)
+{
+#if defined(__GNUC__)
+    __asm__("" : "+r"(value));
+#endif
+    return value;
+}
+
+// all ones if bit (which must be 0 or 1) is set, else zero
+inline CHUNK ctMask(CHUNK bit)
+{
+    return ctBarrier(0 - bit);
+}
+
+// 1 if value is zero, else 0
+inline CHUNK ctIsZero(CHUNK value)
+{
+    return 1 ^ ((value | (0 - value)) >> 63);
+}
+
+// clear memory in a way the optimizer cannot drop as a dead store
+inline void secureZero(CHUNK *limbs, size_t count)
+{
+    volatile CHUNK *target = limbs;
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+	target[i] = 0;
+}
+
+template <unsigned Bits> class CtModulus;
+
+/*******************************************************************
+ * an unsigned Bits-bit value whose arithmetic wraps modulo 2^Bits *
+ * like FixedInt's, but takes the same time for every value.  The  *
+ * limbs are wiped when the value is destroyed or overwritten.     *
+ *******************************************************************/
+template <unsigned Bits>
+class CtInt
+{
+    static_assert(Bits > 0 && Bits % 64 == 0,
+		  "CtInt width must be a multiple of 64 bits");
+
+    template <unsigned> friend class CtModulus;
+
+    public:
+    static const unsigned Limbs = Bits / 64;
+
+    private:
+    CHUNK limbs[Limbs];		// least significant first
+
+    public:
+    CtInt() :limbs()
+    {
+    }
+
+    CtInt(CHUNK value) :limbs()
+    {
+	limbs[0] = value;
+    }
+
+    explicit CtInt(const FixedInt<Bits> &value)
+    {
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i)
+	    limbs[i] = value.limb(i);
+    }
+
+    // the value modulo 2^Bits, negative values in two's complement
+    explicit CtInt(const BigInteger &value)
+    {
+	*this = CtInt(FixedInt<Bits>(value));
+    }
+
+    CtInt(const CtInt &other)
+    {
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i)
+	    limbs[i] = other.limbs[i];
+    }
+
+    CtInt& operator= (const CtInt &other)
+    {
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i)
+	    limbs[i] = other.limbs[i];
+	return *this;
+    }
+
+    ~CtInt()
+    {
+	secureZero(limbs, Limbs);
+    }
+
+    FixedInt<Bits> toFixedInt() const
+    {
+	FixedInt<Bits> answer;
+	unsigned i;
+
+	for (i = Limbs; i > 0; --i)
+	    answer = (answer << 64) | FixedInt<Bits>(limbs[i - 1]);
+	return answer;
+    }
+
+    BigInteger toBigInteger() const
+    {
+	return toFixedInt().toBigInteger();
+    }
+
+    CHUNK limb(unsigned i) const
+    {
+	return limbs[i];
+    }
+
+    /************************************************
+     * this += other, returning the carry out (0/1) *
+     ************************************************/
+    CHUNK addWithCarry(const CtInt &other)
+    {
+	CHUNK carry = 0;
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i) {
+	    CHUNK a = limbs[i], b = other.limbs[i];
+	    CHUNK sum = a + b + carry;
+
+	    carry = ((a & b) | ((a | b) & ~sum)) >> 63;
+	    limbs[i] = sum;
+	}
+	return carry;
+    }
+
+    /*************************************************
+     * this -= other, returning the borrow out (0/1) *
+     *************************************************/
+    CHUNK subtractWithBorrow(const CtInt &other)
+    {
+	CHUNK borrow = 0;
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i) {
+	    CHUNK a = limbs[i], b = other.limbs[i];
+	    CHUNK difference = a - b - borrow;
+
+	    borrow = ((~a & b) | (~(a ^ b) & difference)) >> 63;
+	    limbs[i] = difference;
+	}
+	return borrow;
+    }
+
+    // condition must be 0 or 1
+    static CtInt select(CHUNK condition, const CtInt &ifTrue,
+			const CtInt &ifFalse)
+    {
+	CHUNK mask = ctMask(condition);
+	CtInt answer;
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i)
+	    answer.limbs[i] = ifFalse.limbs[i]
+			      ^ (mask & (ifFalse.limbs[i] ^ ifTrue.limbs[i]));
+	return answer;
+    }
+
+    // swap a and b if condition (0 or 1) is set
+    static void conditionalSwap(CHUNK condition, CtInt &a, CtInt &b)
+    {
+	CHUNK mask = ctMask(condition);
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i) {
+	    CHUNK difference = mask & (a.limbs[i] ^ b.limbs[i]);
+
+	    a.limbs[i] ^= difference;
+	    b.limbs[i] ^= difference;
+	}
+    }
+
+    /*******************************************************
+     * the comparisons return 0 or 1 instead of bool, so a *
+     * result can go straight into select()                *
+     *******************************************************/
+    CHUNK isZero() const
+    {
+	CHUNK bits = 0;
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i)
+	    bits |= limbs[i];
+	return ctIsZero(bits);
+    }
+
+    CHUNK equals(const CtInt &other) const
+    {
+	CHUNK bits = 0;
+	unsigned i;
+
+	for (i = 0; i < Limbs; ++i)
+	    bits |= limbs[i] ^ other.limbs[i];
+	return ctIsZero(bits);
+    }
+
+    CHUNK lessThan(const CtInt &other) const
+    {
+	CtInt difference(*this);
+
+	return difference.subtractWithBorrow(other);
+    }
+
+    // -1, 0 or 1 as this is less than, equal to or greater than other
+    int compare(const CtInt &other) const
+    {
+	CHUNK less = lessThan(other);
+	CHUNK greater = other.lessThan(*this);
+
+	return (int) greater - (int) less;
+    }
+
+    /*************
+     * Operators *
+     *************/
+    CtInt& operator+= (const CtInt &other)
+    {
+	addWithCarry(other);
+	return *this;
+    }
+
+    CtInt& operator-= (const CtInt &other)
+    {
+	subtractWithBorrow(other);
+	return *this;
+    }
+
+    // the product truncated to Limbs limbs; no limb is skipped
+    CtInt& operator*= (const CtInt &other)
+    {
+	CtInt product;
+	unsigned i, j;
+
+	for (i = 0; i < Limbs; ++i) {
+	    CHUNK carry = 0;
+
+	    for (j = 0; i + j < Limbs; ++j) {
+		CHUNK high;
+		CHUNK low = mulChunks(limbs[i], other.limbs[j], high);
+
+		low += carry;
+		high += (low < carry);
+		low += product.limbs[i + j];
+		high += (low < product.limbs[i + j]);
+		product.limbs[i + j] = low;
+		carry = high;
+	    }
+	}
+	return *this = product;
+    }
+
+    CtInt operator+ (const CtInt &other) const
+    {
+	CtInt answer(*this);
+
+	answer += other;
+	return answer;
+    }
+
+    CtInt operator- (const CtInt &other) const
+    {
+	CtInt answer(*this);
+
+	answer -= other;
+	return answer;
+    }
+
+    CtInt operator* (const CtInt &other) const
+    {
+	CtInt answer(*this);
+
+	answer *= other;
+	return answer;
+    }
+
+    bool operator== (const CtInt &other) const
+    {
+	return equals(other) != 0;
+    }
+
+    bool operator!= (const CtInt &other) const
+    {
+	return equals(other) == 0;
+    }
+};
+
+template <unsigned Bits>
+inline std::ostream& operator<< (std::ostream &strm, const CtInt<Bits> &value)
+{
+    value.toBigInteger().writeTo(strm);
+    return strm;
+}
+
+/******************************************************************
+ * arithmetic modulo a public odd modulus of up to Bits bits, in  *
+ * constant time.  Operands and results are ordinary values below *
+ * the modulus (reduce() brings any CtInt there); products go     *
+ * through Montgomery form internally, as MontgomeryContext's do, *
+ * with the final subtraction done as a masked selection.         *
+ ******************************************************************/
+template <unsigned Bits>
+class CtModulus
+{
+    public:
+    typedef CtInt<Bits> Value;
+
+    private:
+    static const unsigned Limbs = Value::Limbs;
+    static const unsigned WindowBits = 4;	// modPow's fixed window
+
+    Value n;
+    Value rModN;		// 1 in Montgomery form
+    Value r2ModN;		// converts into Montgomery form
+    CHUNK nPrime;		// -n^-1 mod 2^64
+
+    /*********************************************************
+     * out = a * b / R mod n, where a * b < n R (CIOS, as in *
+     * MontgomeryContext::multiply); out may alias a or b    *
+     *********************************************************/
+    void montgomeryMultiply(const Value &a, const Value &b, Value &out) const
+    {
+	CHUNK t[Limbs + 2];
+	unsigned i, j;
+
+	for (i = 0; i < Limbs + 2; ++i)
+	    t[i] = 0;
+
+	for (i = 0; i < Limbs; ++i) {
+	    CHUNK carry = 0;
+	    CHUNK high, low;
+
+	    // t += a * b[i]
+	    for (j = 0; j < Limbs; ++j) {
+		low = mulChunks(a.limbs[j], b.limbs[i], high);
+		low += carry;
+		high += (low < carry);
+		t[j] += low;
+		carry = high + (t[j] < low);
+	    }
+	    t[Limbs] += carry;
+	    t[Limbs + 1] = (t[Limbs] < carry);
+
+	    // t = (t + m * n) / 2^64, with m chosen to clear t[0]
+	    CHUNK m = t[0] * nPrime;
+	    low = mulChunks(m, n.limbs[0], high);
+	    carry = high + (t[0] + low < low);
+	    for (j = 1; j < Limbs; ++j) {
+		low = mulChunks(m, n.limbs[j], high);
+		low += carry;
+		high += (low < carry);
+		t[j - 1] = t[j] + low;
+		carry = high + (t[j - 1] < low);
+	    }
+	    t[Limbs - 1] = t[Limbs] + carry;
+	    t[Limbs] = t[Limbs + 1] + (t[Limbs - 1] < carry);
+	}
+
+	// t < 2n: subtract n unless that borrows out of t
+	Value reduced;
+	for (i = 0; i < Limbs; ++i)
+	    reduced.limbs[i] = t[i];
+	Value difference(reduced);
+	CHUNK borrow = difference.subtractWithBorrow(n);
+
+	out = Value::select(t[Limbs] | (borrow ^ 1), difference, reduced);
+	secureZero(t, Limbs + 2);
+    }
+
+    /********************************************************
+     * table[index] without revealing index: every entry is *
+     * read and all but one are masked away                 *
+     ********************************************************/
+    static Value lookup(const Value *table, unsigned count, CHUNK index)
+    {
+	Value answer;
+	unsigned i;
+
+	for (i = 0; i < count; ++i)
+	    answer = Value::select(ctIsZero(index ^ i), table[i], answer);
+	return answer;
+    }
+
+    public:
+    /*****************************************************
+     * the modulus must be odd, greater than one and fit *
+     * in Bits bits; it is not treated as a secret       *
+     *****************************************************/
+    explicit CtModulus(const BigInteger &modulus)
+    {
+	if (modulus.sign == BigInteger::Negative
+		|| !(modulus.magnitude[0] & 1)
+		|| (modulus.magnitude.size() == 1 && modulus.magnitude[0] == 1))
+	    throw("constant-time modulus must be odd and greater than one");
+	if (modulus.magnitude.size() > Limbs)
+	    throw("modulus too wide for CtModulus");
+
+	BigInteger r = BigInteger(1) << BigInteger(Bits);
+	BigInteger rMod = r % modulus;
+
+	n = Value(modulus);
+	rModN = Value(rMod);
+	r2ModN = Value(rMod * rMod % modulus);
+	nPrime = 0 - BigInteger::inverseChunk(modulus.magnitude[0]);
+    }
+
+    const Value &modulus() const
+    {
+	return this->n;
+    }
+
+    // value mod n, for any value below 2^Bits
+    Value reduce(const Value &value) const
+    {
+	Value answer;
+
+	montgomeryMultiply(value, r2ModN, answer);	// value R mod n
+	montgomeryMultiply(answer, Value(1), answer);
+	return answer;
+    }
+
+    Value add(const Value &a, const Value &b) const
+    {
+	Value sum(a);
+	CHUNK carry = sum.addWithCarry(b);
+	Value difference(sum);
+	CHUNK borrow = difference.subtractWithBorrow(n);
+
+	return Value::select(carry | (borrow ^ 1), difference, sum);
+    }
+
+    Value subtract(const Value &a, const Value &b) const
+    {
+	Value difference(a);
+	CHUNK borrow = difference.subtractWithBorrow(b);
+	Value wrapped(difference);
+
+	wrapped.addWithCarry(n);
+	return Value::select(borrow, wrapped, difference);
+    }
+
+    Value multiply(const Value &a, const Value &b) const
+    {
+	Value answer;
+
+	montgomeryMultiply(a, b, answer);		// a b / R
+	montgomeryMultiply(answer, r2ModN, answer);	// a b
+	return answer;
+    }
+
+    /***************************************************************
+     * base^exponent mod n with a fixed 4-bit window: every window *
+     * of the exponent, zero or not, costs four squarings, a table *
+     * scan and a multiplication                                   *
+     ***************************************************************/
+    Value pow(const Value &base, const Value &exponent) const
+    {
+	Value table[1 << WindowBits];
+	Value result(rModN);
+	unsigned i, bit;
+
+	table[0] = rModN;
+	montgomeryMultiply(base, r2ModN, table[1]);
+	for (i = 2; i < (1 << WindowBits); ++i)
+	    montgomeryMultiply(table[i - 1], table[1], table[i]);
+
+	for (bit = Bits; bit > 0; bit -= WindowBits) {
+	    unsigned low = bit - WindowBits;
+	    CHUNK window = (exponent.limbs[low / 64] >> (low % 64))
+			   & ((1 << WindowBits) - 1);
+	    Value factor = lookup(table, 1 << WindowBits, window);
+
+	    for (i = 0; i < WindowBits; ++i)
+		montgomeryMultiply(result, result, result);
+	    montgomeryMultiply(result, factor, result);
+	}
+	montgomeryMultiply(result, Value(1), result);	// leave Montgomery form
+	return result;
+    }
+};
+
+#ifndef BIGINT_NO_MAIN
+/* Driver program to for testing */
+int main(int argc, char *argv[])
+{
+    const BigInteger &bigZero = BigInteger::smallConstant(0);
+    const BigInteger &bigTen = BigInteger::smallConstant(10);
+    if (argc > 1) {
+	static const std::string Octal("octal");
+	static const std::string Hex("hex");
+	if (Octal == argv[1]) {
+	    std::cin >> std::oct;
+	    std::cout << std::oct;
+	} else if (Hex == argv[1]) {
+	    std::cin >> std::hex;
+	    std::cout << std::hex;
+	}
+    }
+    std::cout << "Input and Output in ";
+    if (std::cin.flags() & std::ios::hex)
+	std::cout << "hex\n";
+    else if (std::cin.flags() & std::ios::oct)
+	std::cout << "octal\n";
+    else
+	std::cout << "decimal\n";
+    try {
+	BigInteger i(static_cast<CHUNK>(-3));
+	BigInteger j(8000000000000000011LL);
+	BigInteger k(i);
+	DB(i==k);
+	DB4(i, j, k, i < j);
+	i += j;
+	DB3(i, j, k);
+	DB4(i>j, j>k, i<j, j<k);
+	DB3(i==k,i==j, j==k);
+	BigInteger a1(-7);
+	BigInteger a2(100);
+	BigInteger a3;
+	DB3(a1, a2, a3);
+	a2 += a1;
+	a3 = a1 + a2;
+	DB3(a1, a2, a3);
+	DB3(a1, a2-a1, a3);
+	DB3(a1, a2+a1, a3);
 	DB(a2-=a3);
 	DB(a2);
 	i = j + j;
@@ -1074,8 +8048,149 @@ int main(int argc, char *argv[])
 	BigInteger strToNumOctal("012345671234567123456712345671234567001");
 	DB(strToNumHex);
 	DB(strToNumOctal);
+
+	std::vector<BigInteger> batchA, batchB, batchResult;
+	for (int n = 1; n <= 1000; ++n) {
+	    batchA.push_back(BigInteger(n));
+	    batchB.push_back(strToNum1 + BigInteger(n));
+	}
+	DB(batchSum(batchA));
+	DB(batchSum(batchB));
+	batchModMultiply(batchA, batchB, BigInteger(1000003), batchResult);
+	DB3(batchResult[0], batchResult[500], batchResult[999]);
+	DB(BigInteger(7).modPow(BigInteger(560), BigInteger(561)));
+	DB(BigInteger(-2).modPow(BigInteger(3), BigInteger(10)));
+
+	BigAccumulator accumulator;
+	for (int n = 0; n < 1000; ++n)
+	    accumulator.addProduct(batchA[n], batchB[n]);
+	accumulator -= strToNum3;
+	DB(accumulator.result());
+
+	std::vector<unsigned char> serial = strToNum3.serialize();
+	std::vector<unsigned char> compact = strToNum3.serialize(true);
+	BigIntegerView view(serial);
+	DB3(serial.size(), compact.size(), view.bitLength());
+	DB(BigInteger::deserialize(compact));
+	DB(BigInteger::fromBytes(strToNumHex.toBytes()) == strToNumHex);
+	DB3(view + strToNum1, view * view, view < strToNum1);
+
+#if defined(BIGINT_HAVE_MMAP)
+	{
+	    MappedBigInteger mapped("bigint_mapped.tmp", 4);
+	    MappedBigInteger mappedProduct("bigint_product.tmp", 4);
+	    mapped.assign(strToNum1);
+	    mapped.shiftLeft(100);
+	    MappedBigInteger::multiply(mapped, mapped, mappedProduct);
+	    MappedBigInteger::add(mapped, mappedProduct, mapped);
+	    DB(mapped.toBigInteger());
+	    DB(mappedProduct.view() == BigInteger::deserialize(
+		mappedProduct.toBigInteger().serialize()));
+	}
+	std::remove("bigint_mapped.tmp");
+	std::remove("bigint_product.tmp");
+#endif
+
+	BigInteger big = strToNum2 << BigInteger(3000);
+	big.writeTo(std::cout);
+	std::cout << std::endl;
+	big.writeTo([](const char *, size_t length)
+		    { std::cout << length << " "; },
+		    10);
+	std::cout << std::endl;
+
+	UInt256 fixed(strToNum1);
+	Int128 fixedSigned =
+	    Int128::parse("-170141183460469231731687303715884105728");
+	DB3(fixed * fixed, fixed / UInt256(12345), fixed << 200);
+	DB3(fixedSigned, fixedSigned - 1, -fixedSigned == fixedSigned);
+	DB(UInt256(fixed.toBigInteger() * strToNum2) == fixed * UInt256(strToNum2));
+
+	BigInteger mersenne127("170141183460469231731687303715884105727");
+	MontgomeryContext field(mersenne127);
+	FieldElement element(field, strToNum1);
+	FieldElement other(field, strToNum2);
+	std::vector<FieldElement> elements(3, element);
+	elements[1] = other;
+	elements[2] = element * other - element;
+	FieldElement::batchInvert(elements);
+	DB3(element + other, element * other, element.pow(BigInteger(65537)));
+	DB3(elements[0] * element, elements[2], element.inverse());
+
+	RnsBasis basis(512);
+	RnsInteger residue1(basis, strToNum1);
+	RnsInteger residue2(basis, strToNum2);
+	RnsInteger residue3(basis, strToNum3);
+	DB3(basis.size(), residue1 * residue2 - residue3,
+	    strToNum1 * strToNum2 - strToNum3);
+	DB(-(residue1 * residue1 * residue2));
+
+	std::unordered_set<BigInteger> seen;
+	seen.insert(strToNum1);
+	seen.insert(strToNum2);
+	seen.insert(strToNum1 * bigTen / bigTen);
+	DB3(seen.size(), seen.count(strToNum2), strToNum1.hash() != strToNum2.hash());
+	DB(&intern(strToNum1 + strToNum2) == &intern(strToNum2 + strToNum1));
+
+	BigInteger product = strToNum1 * strToNum2 * strToNum3;
+	DB3(product.divExact(strToNum2), product.divExact(strToNum2 * strToNum3),
+	    product.divExact(-strToNum1));
+	DB3(product.isDivisibleBy(strToNum3),
+	    (product + bigTen).isDivisibleBy(strToNum1),
+	    product.isDivisibleBy(BigInteger(1) << BigInteger(3)));
+
+	FixedBasePow powersOfTen(bigTen, 6);
+	DB3(strToNum2.pow(BigInteger(5)), pow(-strToNum1, BigInteger(3)),
+	    BigInteger(1024).pow(BigInteger(10)));
+	DB(powersOfTen.pow(BigInteger(40)) == bigTen.pow(BigInteger(40)));
+
+	CtModulus<128> ctField(field.modulus());
+	CtInt<128> secret(strToNum2);
+	DB3(ctField.pow(CtInt<128>(strToNum1), secret),
+	    FieldElement(field, strToNum1).pow(strToNum2),
+	    CtInt<128>::select(secret.lessThan(CtInt<128>(strToNum1)),
+			       secret, CtInt<128>(strToNum1)));
+
+	Xoshiro256 seeded(2024);
+	std::vector<BigInteger> samples(3);
+	batchRandomBelow(samples, strToNum1, seeded);
+	DB3(BigInteger::random(100, seeded),
+	    BigInteger::randomOfLength(100, seeded).bitLength(), samples[2]);
+
+	SharedBigInteger shared(strToNum1 * strToNum2);
+	SharedBigInteger sharedCopy = shared;
+	DB3(sharedCopy.useCount(), sharedCopy.sharesStorageWith(shared),
+	    sharedCopy == shared);
+	sharedCopy += bigTen;
+	DB3(shared, sharedCopy, shared.useCount());
+
+	CancellationToken token;
+	std::future<BigInteger> asyncProduct =
+	    BigIntegerAsync::multiply(strToNum1, strToNum2, token);
+	std::future<std::string> asyncDigits =
+	    BigIntegerAsync::toString(BigInteger::factorial(30), 16);
+	DB3(asyncProduct.get(), asyncDigits.get(),
+	    BigIntegerAsync::factorial(25).get());
+
+	BigDecimalInteger decimal("123456789012345678901234567890");
+	BigDecimalInteger decimalCopy(strToNum1);
+	DB3(decimal * 3 - decimalCopy, decimal.digitCount(),
+	    decimalCopy.toBigInteger() == strToNum1);
+
+#if defined(BIGINT_INSTRUMENT)
+	instrumentReset();
+	DB(strToNum1 * strToNum2 + strToNum3 / strToNum1);
+	InstrumentSnapshot snapshot = instrumentSnapshot();
+	for (int op = 0; op < NumInstrumentedOperations; ++op) {
+	    const OperationStats &stats = snapshot.operations[op];
+	    if (stats.calls)
+		DB4(instrumentOperationName((InstrumentedOperation) op),
+		    stats.calls, stats.limbs, stats.nanoseconds);
+	}
+#endif
     } catch (char const* &e) {
 	std::cout << "Error: " << e << std::endl;
 	return 1;
     }
 }
+#endif	// BIGINT_NO_MAIN
@@ -0,0 +1,529 @@
+/*
+ * Benchmark driver for BigInteger
+ *
+ * Times each operation over operand sizes from 1 limb up to
+ * --max-limbs (10^6 by default) on random and adversarial inputs,
+ * and writes one JSON record per case so results can be compared
+ * between releases.  The constant-time modular pow is also timed on
+ * exponents as different as possible, to show that its time does
+ * not depend on them (--only ct-modpow runs just that).
+ *
+ * The operators still work a bit at a time; the -limb cases drive
+ * the limb kernels instead, on both sides of the Karatsuba cutoff.
+ * Each record's "algorithm" is the tier the library reports having
+ * chosen, so the bench is built with BIGINT_INSTRUMENT; its spans
+ * add a few clock reads to every timed call.
+ *
+ * build: g++ -O2 -std=c++11 -pthread bigint_bench.cpp -o bigint_bench
+ * usage: bigint_bench [--max-limbs N] [--min-time MS] [--budget MS]
+ *                     [--only OP] [--output FILE]
+ */
+#define BIGINT_NO_MAIN
+#if !defined(BIGINT_INSTRUMENT)
+#define BIGINT_INSTRUMENT	// to learn which tier each case ran
+#endif
+#include "bigint.cpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+/***************************************************************
+ * allocation counting: every heap allocation in the process *
+ * goes through these, so allocations/op can be reported      *
+ ***************************************************************/
+static std::atomic<unsigned long long> allocationCount(0);
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// the replacements below pair malloc with free, whatever gcc infers
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+	return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/*************************************************************
+ * a value of exactly 'limbs' limbs built from raw bytes     *
+ * pattern 0 is random, 1 is all ones (longest carry chains) *
+ * the bytes come from a fixed-seed SplitMix64, so every run *
+ * measures exactly the same values                          *
+ *************************************************************/
+static BigInteger makeOperand(ULONG limbs, int pattern, SplitMix64 &random)
+{
+    std::vector<unsigned char> bytes(limbs * sizeof(CHUNK));
+    ULONG i;
+
+    for (i = 0; i < bytes.size(); ++i)
+	bytes[i] = pattern == 1 ? 0xff : (unsigned char) random.next();
+    bytes[bytes.size() - 1] |= 0x80;	// keep the full length
+    return BigInteger::fromBytes(bytes, BigInteger::LittleEndian);
+}
+
+/***********************************************************
+ * one benchmarked operation                               *
+ * complexity is the exponent used to predict how long    *
+ * the next size up will take, so hopeless sizes are      *
+ * skipped instead of running for hours                   *
+ * operation is the instrumented operation whose tier is  *
+ * reported, or -1 for cases with a single algorithm,     *
+ * which 'algorithm' then describes                       *
+ ***********************************************************/
+struct BenchOperands {
+    BigInteger a, b;
+    std::string text;
+};
+
+struct BenchCase {
+    const char *name;
+    const char *algorithm;
+    int operation;
+    double complexity;
+    void (*prepare)(ULONG limbs, int pattern, SplitMix64 &random,
+		    BenchOperands &operands);
+    ULONG (*run)(const BenchOperands &operands);
+};
+
+static void prepareTwo(ULONG limbs, int pattern, SplitMix64 &random,
+		       BenchOperands &operands)
+{
+    operands.a = makeOperand(limbs, pattern, random);
+    operands.b = makeOperand(limbs, pattern, random);
+}
+
+// adversarial: all ones + 1 carries through every limb
+static void prepareCarry(ULONG limbs, int pattern, SplitMix64 &random,
+			 BenchOperands &operands)
+{
+    prepareTwo(limbs, pattern, random, operands);
+    if (pattern == 1)
+	operands.b = 1;
+}
+
+// adversarial: 2^(64 * limbs) - 1 borrows through every limb
+static void prepareBorrow(ULONG limbs, int pattern, SplitMix64 &random,
+			  BenchOperands &operands)
+{
+    prepareTwo(limbs, pattern, random, operands);
+    if (pattern == 1) {
+	operands.a += 1;
+	operands.b = 1;
+    }
+}
+
+static void prepareDivide(ULONG limbs, int pattern, SplitMix64 &random,
+			  BenchOperands &operands)
+{
+    ULONG divisorLimbs = limbs / 2 ? limbs / 2 : 1;
+
+    operands.a = makeOperand(limbs, pattern, random);
+    operands.b = makeOperand(divisorLimbs, 0, random);
+    if (pattern == 1)	// top bit only: the worst case for estimates
+	operands.b = BigInteger(1) << BigInteger(divisorLimbs * 64 - 1);
+}
+
+static void prepareParse(ULONG limbs, int pattern, SplitMix64 &random,
+			 BenchOperands &operands)
+{
+    std::string digits;
+
+    operands.a = makeOperand(limbs, pattern, random);
+    operands.a.writeTo([&digits](const char *text, size_t length)
+		       { digits.append(text, length); });
+    operands.text = digits;
+}
+
+static ULONG runAdd(const BenchOperands &x)
+{
+    return (x.a + x.b).bitLength();
+}
+
+static ULONG runSubtract(const BenchOperands &x)
+{
+    return (x.a - x.b).bitLength();
+}
+
+static ULONG runMultiply(const BenchOperands &x)
+{
+    return (x.a * x.b).bitLength();
+}
+
+static ULONG runSquare(const BenchOperands &x)
+{
+    return (x.a * x.a).bitLength();
+}
+
+static ULONG runDivide(const BenchOperands &x)
+{
+    return (x.a / x.b).bitLength();
+}
+
+static ULONG runMod(const BenchOperands &x)
+{
+    return (x.a % x.b).bitLength();
+}
+
+static ULONG runShiftLeft(const BenchOperands &x)
+{
+    return (x.a << BigInteger(37)).bitLength();
+}
+
+static ULONG runShiftRight(const BenchOperands &x)
+{
+    return (x.a >> BigInteger(37)).bitLength();
+}
+
+static ULONG runAnd(const BenchOperands &x)
+{
+    return (x.a & x.b).bitLength();
+}
+
+static ULONG runOr(const BenchOperands &x)
+{
+    return (x.a | x.b).bitLength();
+}
+
+static ULONG runParse(const BenchOperands &x)
+{
+    return BigInteger(x.text).bitLength();
+}
+
+// a fresh value the size of a from the default xoshiro256** source
+static ULONG runRandom(const BenchOperands &x)
+{
+    return BigInteger::random(x.a.bitLength()).bitLength();
+}
+
+// the limb kernels, through the batch routines' per-thread worker
+static ULONG runLimbMultiply(const BenchOperands &x)
+{
+    BigInteger product;
+
+    BatchWorker::local().multiply(x.a, x.b, product);
+    return product.bitLength();
+}
+
+// pow(a, 2) is a single squareMagnitude of a's odd part
+static ULONG runLimbSquare(const BenchOperands &x)
+{
+    return x.a.pow(BigInteger(2)).bitLength();
+}
+
+static ULONG runLimbMod(const BenchOperands &x)
+{
+    BigInteger remainder;
+
+    BatchWorker::local().mod(x.a, x.b, remainder);
+    return remainder.bitLength();
+}
+
+static ULONG runPrint(const BenchOperands &x)
+{
+    ULONG digits = 0;
+
+    x.a.writeTo([&digits](const char *, size_t length)
+		{ digits += length; });
+    return digits;
+}
+
+static const BenchCase benchCases[] = {
+    { "add",	"limb carry chain",	OpAdd,		1, prepareCarry,
+      runAdd },
+    { "sub",	"limb borrow chain",	OpAdd,		1, prepareBorrow,
+      runSubtract },
+    { "mul",	"binary shift-add",	OpMultiply,	2, prepareTwo,
+      runMultiply },
+    { "square",	"binary shift-add",	OpMultiply,	2, prepareTwo,
+      runSquare },
+    { "div",	"binary shift-subtract", OpDivide,	2, prepareDivide,
+      runDivide },
+    { "mod",	"binary shift-subtract", OpDivide,	2, prepareDivide,
+      runMod },
+    { "mul-limb", "limb kernel",	OpLimbMultiply,	1.585, prepareTwo,
+      runLimbMultiply },
+    { "square-limb", "limb kernel",	OpLimbMultiply,	1.585, prepareTwo,
+      runLimbSquare },
+    { "mod-limb", "limb kernel",	OpLimbDivide,	2, prepareDivide,
+      runLimbMod },
+    { "shl",	"1 bit per pass",	-1,		1, prepareTwo,
+      runShiftLeft },
+    { "shr",	"1 bit per pass",	-1,		1, prepareTwo,
+      runShiftRight },
+    { "and",	"limb-wise",		-1,		1, prepareTwo,
+      runAnd },
+    { "or",	"limb-wise",		-1,		1, prepareTwo,
+      runOr },
+    { "parse",	"multiply-add per digit", OpParse,	2, prepareParse,
+      runParse },
+    { "print",	"divide-and-conquer",	OpPrint,	2, prepareTwo,
+      runPrint },
+    { "random",	"xoshiro256** limb fill", -1,		1, prepareTwo,
+      runRandom },
+};
+
+/***************************************************************
+ * run the case once more with fresh counters and report the    *
+ * tiers its operation went through; the algorithm is the       *
+ * highest of them, which is the one the outermost call chose,  *
+ * since a divide-and-conquer call ends in schoolbook leaves    *
+ ***************************************************************/
+static void reportTiers(std::ostream &json, const BenchCase &benchCase,
+			const BenchOperands &operands, volatile ULONG &keep)
+{
+    const char *algorithm = benchCase.algorithm;
+    bool firstTier = true;
+    int tier;
+
+    if (benchCase.operation >= 0) {
+	instrumentReset();
+	keep += benchCase.run(operands);
+	InstrumentSnapshot snapshot = instrumentSnapshot();
+	const OperationStats &stats =
+	    snapshot.operations[benchCase.operation];
+
+	json << ", \"tiers\": {";
+	for (tier = 0; tier < NumAlgorithmTiers; ++tier)
+	    if (stats.tierCalls[tier]) {
+		json << (firstTier ? " \"" : ", \"")
+		     << instrumentTierName((AlgorithmTier) tier) << "\": "
+		     << stats.tierCalls[tier];
+		firstTier = false;
+		algorithm = instrumentTierName((AlgorithmTier) tier);
+	    }
+	json << (firstTier ? "}" : " }");
+    }
+    json << ", \"algorithm\": \"" << algorithm << "\"";
+}
+
+static const char *patternNames[] = { "random", "adversarial" };
+
+/*************************************************************
+ * time work() until minTime has passed; the seconds per op *
+ *************************************************************/
+template <class Work>
+static double secondsPerOp(Work work, double minTime, volatile ULONG &keep)
+{
+    ULONG iterations = 1;
+
+    for (;;) {
+	std::chrono::steady_clock::time_point start =
+	    std::chrono::steady_clock::now();
+	for (ULONG n = 0; n < iterations; ++n)
+	    keep += work();
+	double seconds = std::chrono::duration<double>(
+	    std::chrono::steady_clock::now() - start).count();
+	if (seconds >= minTime)
+	    return seconds / iterations;
+	iterations *= 2;
+    }
+}
+
+/****************************************************************
+ * timing variance of modular pow over exponents of very        *
+ * different weight, constant-time CtModulus next to the        *
+ * variable-time FieldElement; each exponent keeps the fastest  *
+ * of several rounds, so noise does not pass for a dependence   *
+ ****************************************************************/
+static const char *exponentNames[] = {
+    "zero", "one", "sparse", "random", "all-ones"
+};
+static const int exponentKinds = 5;
+static const int varianceRounds = 3;
+
+template <unsigned Bits>
+static void benchTimingVariance(std::ostream &json, double minTime,
+				volatile ULONG &keep, bool &first)
+{
+    const ULONG limbs = Bits / 64;
+    SplitMix64 random(54321);
+    BigInteger modulus = makeOperand(limbs, 0, random) | BigInteger(1);
+    BigInteger base = makeOperand(limbs, 0, random) % modulus;
+    BigInteger exponents[exponentKinds];
+    CtModulus<Bits> ctModulus(modulus);
+    MontgomeryContext context(modulus);
+    FieldElement element(context, base);
+    CtInt<Bits> ctBase(base);
+    double seconds[2][exponentKinds];
+    int variant, kind, round;
+
+    exponents[0] = 0;
+    exponents[1] = 1;
+    exponents[2] = BigInteger(1) << BigInteger(Bits - 1);
+    exponents[3] = makeOperand(limbs, 0, random);
+    exponents[4] = makeOperand(limbs, 1, random);
+
+    for (variant = 0; variant < 2; ++variant)
+	for (kind = 0; kind < exponentKinds; ++kind)
+	    seconds[variant][kind] = 0;
+    for (round = 0; round < varianceRounds; ++round)
+	for (kind = 0; kind < exponentKinds; ++kind) {
+	    CtInt<Bits> ctExponent(exponents[kind]);
+	    const BigInteger &exponent = exponents[kind];
+	    double ct = secondsPerOp([&]() -> ULONG
+		{ return ctModulus.pow(ctBase, ctExponent).limb(0); },
+		minTime, keep);
+	    double vt = secondsPerOp([&]() -> ULONG
+		{ return element.pow(exponent).isZero(); }, minTime, keep);
+
+	    if (round == 0 || ct < seconds[0][kind])
+		seconds[0][kind] = ct;
+	    if (round == 0 || vt < seconds[1][kind])
+		seconds[1][kind] = vt;
+	}
+
+    for (variant = 0; variant < 2; ++variant) {
+	const char *name = variant == 0 ? "ct-modpow" : "modpow";
+	double fastest = seconds[variant][0];
+	double slowest = seconds[variant][0];
+
+	for (kind = 0; kind < exponentKinds; ++kind) {
+	    json << (first ? "\n" : ",\n") << "    { \"op\": \"" << name
+		 << "\", \"bits\": " << Bits << ", \"exponent\": \""
+		 << exponentNames[kind] << "\", \"ns_per_op\": "
+		 << seconds[variant][kind] * 1e9 << " }";
+	    first = false;
+	    fastest = std::min(fastest, seconds[variant][kind]);
+	    slowest = std::max(slowest, seconds[variant][kind]);
+	}
+	// (slowest - fastest) / fastest: near zero for constant time
+	json << ",\n    { \"op\": \"" << name << "\", \"bits\": " << Bits
+	     << ", \"spread\": " << (slowest - fastest) / fastest << " }";
+	json.flush();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG maxLimbs = 1000000;
+    double minTime = 0.2;	// seconds of timing per case
+    double budget = 10.0;	// longest single iteration worth attempting
+    std::string only;
+    std::string outputName;
+    volatile ULONG keep = 0;	// results are kept so work is not elided
+    int i;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+	std::string option(argv[i]);
+
+	if (option == "--max-limbs")
+	    maxLimbs = std::strtoull(argv[i + 1], 0, 10);
+	else if (option == "--min-time")
+	    minTime = std::atof(argv[i + 1]) / 1000;
+	else if (option == "--budget")
+	    budget = std::atof(argv[i + 1]) / 1000;
+	else if (option == "--only")
+	    only = argv[i + 1];
+	else if (option == "--output")
+	    outputName = argv[i + 1];
+	else {
+	    std::cerr << "unknown option " << option << std::endl;
+	    return 2;
+	}
+    }
+
+    std::ofstream outputFile;
+    if (!outputName.empty())
+	outputFile.open(outputName.c_str());
+    std::ostream &json = outputName.empty() ? std::cout : outputFile;
+
+    json << "{\n  \"benchmark\": \"bigint\",\n  \"results\": [";
+    bool first = true;
+
+    try {
+	for (const BenchCase &benchCase : benchCases) {
+	    if (!only.empty() && only != benchCase.name)
+		continue;
+
+	    for (int pattern = 0; pattern < 2; ++pattern) {
+		double lastSeconds = 0;
+		double lastPrepare = 0;
+		ULONG lastLimbs = 0;
+		SplitMix64 random(12345);
+
+		for (ULONG limbs = 1; limbs <= maxLimbs; limbs *= 10) {
+		    json << (first ? "\n" : ",\n") << "    { \"op\": \""
+			 << benchCase.name << "\", \"input\": \""
+			 << patternNames[pattern] << "\", \"limbs\": "
+			 << limbs;
+		    first = false;
+
+		    // predict this size, setup included, from the last one
+		    double ratio = lastLimbs ? (double) limbs / lastLimbs : 1;
+		    double predicted = (lastPrepare + lastSeconds)
+				       * std::pow(ratio, benchCase.complexity);
+		    if (predicted > budget) {
+			json << ", \"skipped\": \"over time budget\" }";
+			continue;
+		    }
+
+		    BenchOperands operands;
+		    std::chrono::steady_clock::time_point prepareStart =
+			std::chrono::steady_clock::now();
+		    benchCase.prepare(limbs, pattern, random, operands);
+		    lastPrepare = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - prepareStart).count();
+		    reportTiers(json, benchCase, operands, keep);  // warms up
+
+		    ULONG iterations = 1;
+		    double seconds;
+		    unsigned long long allocations;
+		    for (;;) {
+			unsigned long long startAllocations = allocationCount;
+			std::chrono::steady_clock::time_point start =
+			    std::chrono::steady_clock::now();
+			for (ULONG n = 0; n < iterations; ++n)
+			    keep += benchCase.run(operands);
+			seconds = std::chrono::duration<double>(
+			    std::chrono::steady_clock::now() - start).count();
+			allocations = allocationCount - startAllocations;
+			if (seconds >= minTime || seconds / iterations > budget)
+			    break;
+			iterations *= 2;
+		    }
+
+		    double perOp = seconds / iterations;
+		    json << ", \"iterations\": " << iterations
+			 << ", \"ns_per_op\": " << perOp * 1e9
+			 << ", \"limbs_per_second\": " << limbs / perOp
+			 << ", \"allocs_per_op\": "
+			 << (double) allocations / iterations << " }";
+		    json.flush();
+
+		    lastSeconds = perOp;
+		    lastLimbs = limbs;
+		}
+	    }
+	}
+
+	json << "\n  ],\n  \"timing_variance\": [";
+	first = true;
+	if (only.empty() || only == "ct-modpow") {
+	    benchTimingVariance<256>(json, minTime, keep, first);
+	    benchTimingVariance<2048>(json, minTime, keep, first);
+	}
+    } catch (char const* &e) {
+	std::cerr << "Error: " << e << std::endl;
+	return 1;
+    }
+
+    json << "\n  ]\n}\n";
+    return 0;
+}